@@ -3,91 +3,468 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+class MontgomeryContext;
+
+// 每个线程一个的 limb 临时分配区：按块预留内存，分配只移动偏移量，释放时不逐个归还。
+// 在 Scope 生效期间，LimbVector 扩容改从这里取空间；最外层 Scope 结束时偏移量整体归零（O(1)），
+// 已申请的块留给下一次使用。嵌套的 Scope 不单独回退。
+// 约束：Scope 内分配的缓冲区不能活过该 Scope——结果要在 Scope 外使用时，须在 Suspend 下复制一份。
+class LimbArena {
+public:
+    using Limb = uint64_t;
+    static constexpr size_t CHUNK_LIMBS = 8192; // 每块 64 KiB，更大的请求直接走堆
+
+    static LimbArena& current() {
+        thread_local LimbArena arena;
+        return arena;
+    }
+
+    // 当前线程的 Scope 生效且未被 Suspend 时分配，否则返回 nullptr，由调用方改用堆
+    Limb* allocate(size_t n) {
+        if (depth == 0 || suspended > 0 || n > CHUNK_LIMBS) return nullptr;
+        while (chunkIndex < chunks.size()) {
+            if (CHUNK_LIMBS - offset >= n) {
+                Limb* p = chunks[chunkIndex].get() + offset;
+                offset += n;
+                return p;
+            }
+            ++chunkIndex;
+            offset = 0;
+        }
+        chunks.emplace_back(new Limb[CHUNK_LIMBS]);
+        chunkIndex = chunks.size() - 1;
+        offset = n;
+        return chunks.back().get();
+    }
+
+    // 标记一次完整运算（如一个密文块的模幂）的临时对象范围
+    class Scope {
+    public:
+        Scope() : arena(current()) { ++arena.depth; }
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        LimbArena& arena;
+    };
+
+    // 暂时停用分配区，期间新分配的缓冲区来自堆，用于复制需要长期保留的结果
+    class Suspend {
+    public:
+        Suspend() : arena(current()) { ++arena.suspended; }
+        ~Suspend() { --arena.suspended; }
+        Suspend(const Suspend&) = delete;
+        Suspend& operator=(const Suspend&) = delete;
+
+    private:
+        LimbArena& arena;
+    };
+
+private:
+    std::vector<std::unique_ptr<Limb[]>> chunks;
+    size_t chunkIndex = 0;
+    size_t offset = 0;
+    int depth = 0;
+    int suspended = 0;
+
+    LimbArena() = default;
+};
+
+// BigInt 的 limb 存储：不超过 INLINE_CAPACITY 个 limb 时直接放在对象内部，
+// 超出后才在堆上分配（处于 LimbArena::Scope 中时从线程分配区取）。小整数常量和 64 位以内的中间结果因此不再触发堆分配。
+class LimbVector {
+public:
+    using Limb = uint64_t;
+    static constexpr size_t INLINE_CAPACITY = 8;
+
+    LimbVector() : ptr(inlineBuf), len(0), cap(INLINE_CAPACITY) {}
+
+    LimbVector(size_t n, Limb value) : LimbVector() {
+        assign(n, value);
+    }
+
+    LimbVector(const LimbVector& other) : LimbVector() {
+        reserve(other.len);
+        std::copy(other.ptr, other.ptr + other.len, ptr);
+        len = other.len;
+    }
+
+    LimbVector(LimbVector&& other) noexcept : LimbVector() {
+        moveFrom(other);
+    }
+
+    LimbVector& operator=(const LimbVector& other) {
+        if (this != &other) {
+            len = 0;
+            reserve(other.len);
+            std::copy(other.ptr, other.ptr + other.len, ptr);
+            len = other.len;
+        }
+        return *this;
+    }
+
+    LimbVector& operator=(LimbVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    ~LimbVector() {
+        release();
+    }
+
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    size_t capacity() const { return cap; }
+
+    Limb* data() { return ptr; }
+    const Limb* data() const { return ptr; }
+    Limb* begin() { return ptr; }
+    Limb* end() { return ptr + len; }
+    const Limb* begin() const { return ptr; }
+    const Limb* end() const { return ptr + len; }
+
+    Limb& operator[](size_t i) { return ptr[i]; }
+    const Limb& operator[](size_t i) const { return ptr[i]; }
+    Limb& back() { return ptr[len - 1]; }
+    const Limb& back() const { return ptr[len - 1]; }
+
+    // 容量只增不减：已分配的堆空间在 clear/resize 缩小后仍保留，便于复用
+    void reserve(size_t n) {
+        if (n <= cap) return;
+        size_t newCap = std::max(n, cap * 2);
+        Limb* buf = LimbArena::current().allocate(newCap);
+        bool fromArena = buf != nullptr;
+        if (!fromArena) buf = new Limb[newCap];
+        std::copy(ptr, ptr + len, buf);
+        release();
+        ptr = buf;
+        cap = newCap;
+        arenaOwned = fromArena;
+    }
+
+    void resize(size_t n, Limb value = 0) {
+        reserve(n);
+        if (n > len) std::fill(ptr + len, ptr + n, value);
+        len = n;
+    }
+
+    void assign(size_t n, Limb value) {
+        reserve(n);
+        std::fill(ptr, ptr + n, value);
+        len = n;
+    }
+
+    // 复制 src[0, n)；src 可以指向自身缓冲区
+    void assign(const Limb* src, size_t n) {
+        if (src != ptr) {
+            reserve(n);
+            std::copy(src, src + n, ptr);
+        }
+        len = n;
+    }
+
+    void push_back(Limb value) {
+        if (len == cap) reserve(len + 1);
+        ptr[len++] = value;
+    }
+
+    void pop_back() { --len; }
+    void clear() { len = 0; }
+
+    void swap(LimbVector& other) noexcept {
+        LimbVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    // 用临时缓冲区 scratch 的内容替换自身（scratch 之后的内容不确定）。
+    // scratch 的缓冲区来自分配区而自身不是时，在 Suspend 下复制而不交换，
+    // 避免 Scope 外声明的对象接管分配区内存；其余情况直接交换缓冲区。
+    void takeFrom(LimbVector& scratch) {
+        if (scratch.arenaOwned && !arenaOwned) {
+            LimbArena::Suspend suspend;
+            assign(scratch.ptr, scratch.len);
+        } else {
+            swap(scratch);
+        }
+    }
+
+    bool operator==(const LimbVector& other) const {
+        return len == other.len && std::equal(ptr, ptr + len, other.ptr);
+    }
+
+    bool operator!=(const LimbVector& other) const {
+        return !(*this == other);
+    }
+
+    // 丢弃来自分配区的缓冲区（内容一并清空），分配区回退前由 LimbArena::Scope 调用
+    void dropArenaBuffer() {
+        if (!arenaOwned) return;
+        ptr = inlineBuf;
+        len = 0;
+        cap = INLINE_CAPACITY;
+        arenaOwned = false;
+    }
+
+private:
+    Limb* ptr;
+    size_t len;
+    size_t cap;
+    bool arenaOwned = false; // 缓冲区来自 LimbArena，不能 delete
+    Limb inlineBuf[INLINE_CAPACITY];
+
+    bool isInline() const { return ptr == inlineBuf; }
+
+    void release() {
+        if (!isInline() && !arenaOwned) delete[] ptr;
+        ptr = inlineBuf;
+        cap = INLINE_CAPACITY;
+        arenaOwned = false;
+    }
+
+    // 要求自身处于内联状态；堆上的数据直接接管指针，内联数据逐个复制
+    void moveFrom(LimbVector& other) {
+        if (other.isInline()) {
+            std::copy(other.ptr, other.ptr + other.len, inlineBuf);
+        } else {
+            ptr = other.ptr;
+            cap = other.cap;
+            arenaOwned = other.arenaOwned;
+            other.ptr = other.inlineBuf;
+            other.cap = INLINE_CAPACITY;
+            other.arenaOwned = false;
+        }
+        len = other.len;
+        other.len = 0;
+    }
+};
 
 class BigInt {
 public:
-    BigInt() : digits(1, 0), negative(false) {}
+    using Limb = uint64_t;              // 单个limb（基数 2^64）
+    using DLimb = unsigned __int128;    // 双宽度，用于乘法和进位
+    static constexpr int LIMB_BITS = 64;
+
+    // 乘法算法切换阈值（按较短操作数的 limb 数），可在运行时调整以便基准测试
+    static inline size_t karatsubaThreshold = 32;
+
+    BigInt() : negative(false) {}
     BigInt(const std::string& num) { fromString(num); }
     BigInt(long long num) { fromLongLong(num); }
 
-    // ӷ
+    BigInt(const BigInt&) = default;
+    BigInt(BigInt&&) noexcept = default;
+    BigInt& operator=(const BigInt&) = default;
+    BigInt& operator=(BigInt&&) noexcept = default;
+
+    void swap(BigInt& other) noexcept {
+        limbs.swap(other.limbs);
+        std::swap(negative, other.negative);
+    }
+
+    // 加法
     BigInt operator+(const BigInt& other) const {
         if (negative == other.negative) {
             BigInt result = addAbs(*this, other);
             result.negative = negative;
+            result.trim();
             return result;
         } else {
             if (absGreaterOrEqual(*this, other)) {
                 BigInt result = subAbs(*this, other);
                 result.negative = negative;
+                result.trim();
                 return result;
             } else {
                 BigInt result = subAbs(other, *this);
                 result.negative = other.negative;
+                result.trim();
                 return result;
             }
         }
     }
 
-    // 
+    // 减法
     BigInt operator-(const BigInt& other) const {
         if (negative != other.negative) {
             BigInt result = addAbs(*this, other);
             result.negative = negative;
+            result.trim();
             return result;
         } else {
             if (absGreaterOrEqual(*this, other)) {
                 BigInt result = subAbs(*this, other);
                 result.negative = negative;
+                result.trim();
                 return result;
             } else {
                 BigInt result = subAbs(other, *this);
                 result.negative = !other.negative;
+                result.trim();
                 return result;
             }
         }
     }
 
-    // ˷
+    // 乘法（按长度自动选择小学乘法或 Karatsuba）
     BigInt operator*(const BigInt& other) const {
         BigInt result;
-        result.digits.clear();
-        result.digits.resize(digits.size() + other.digits.size(), 0);
-        
-        for (size_t i = 0; i < digits.size(); ++i) {
-            int carry = 0;
-            for (size_t j = 0; j < other.digits.size() || carry; ++j) {
-                long long cur = result.digits[i + j] + 
-                    (long long)digits[i] * (j < other.digits.size() ? other.digits[j] : 0) + carry;
-                result.digits[i + j] = cur % 10;
-                carry = cur / 10;
-            }
-        }
-        
+        if (isZero() || other.isZero()) return result;
+        result.limbs.resize(limbs.size() + other.limbs.size());
+        mulLimbs(limbs.data(), limbs.size(), other.limbs.data(), other.limbs.size(), result.limbs.data());
         result.negative = (negative != other.negative);
-        return result.trim();
+        result.trim();
+        return result;
     }
 
-    // 
+    // 除法
     BigInt operator/(const BigInt& other) const {
-        if (other == BigInt(0)) throw std::runtime_error("Division by zero");
-        return divMod(other).first;
+        BigInt quotient, remainder;
+        divModInto(*this, other, &quotient, remainder, threadWorkspace());
+        return quotient;
     }
 
-    // ȡģ
+    // 取模（结果总为非负）
     BigInt operator%(const BigInt& other) const {
-        if (other == BigInt(0)) throw std::runtime_error("Division by zero");
-        BigInt result = divMod(other).second;
-        if (result.negative && !result.isZero()) {
-            result = other - result;
-            result.negative = false;
+        if (other.isZero()) throw std::runtime_error("Division by zero");
+        BigInt result;
+        modLimbs(limbs.data(), limbs.size(), negative, other, result, threadWorkspace());
+        return result;
+    }
+
+    // 复合赋值：直接在自身的 limb 缓冲区上运算，容量足够时不再分配内存
+    BigInt& operator+=(const BigInt& other) {
+        if (negative == other.negative) {
+            addMagnitude(limbs, other.limbs);
+        } else if (compareAbs(*this, other) >= 0) {
+            subMagnitude(limbs, other.limbs);
+        } else {
+            reverseSubMagnitude(limbs, other.limbs);
+            negative = other.negative;
+        }
+        trim();
+        return *this;
+    }
+
+    BigInt& operator-=(const BigInt& other) {
+        if (negative != other.negative) {
+            addMagnitude(limbs, other.limbs);
+        } else if (compareAbs(*this, other) >= 0) {
+            subMagnitude(limbs, other.limbs);
+        } else {
+            reverseSubMagnitude(limbs, other.limbs);
+            negative = !other.negative;
+        }
+        trim();
+        return *this;
+    }
+
+    // 乘积先写入线程的临时缓冲，再换入自身（见 LimbVector::takeFrom）
+    BigInt& operator*=(const BigInt& other) {
+        if (isZero() || other.isZero()) {
+            limbs.clear();
+            negative = false;
+            return *this;
+        }
+        LimbVector& prod = threadWorkspace().prod;
+        prod.resize(limbs.size() + other.limbs.size());
+        mulLimbs(limbs.data(), limbs.size(), other.limbs.data(), other.limbs.size(), prod.data());
+        limbs.takeFrom(prod);
+        negative = (negative != other.negative);
+        trim();
+        return *this;
+    }
+
+    BigInt& operator%=(const BigInt& other) {
+        if (other.isZero()) throw std::runtime_error("Division by zero");
+        modLimbs(limbs.data(), limbs.size(), negative, other, *this, threadWorkspace());
+        return *this;
+    }
+
+    // out = (a * b) mod m，结果非负。out 可以与 a 或 b 为同一对象，但不能是 m
+    static void mulMod(const BigInt& a, const BigInt& b, const BigInt& m, BigInt& out) {
+        if (m.isZero()) throw std::runtime_error("Division by zero");
+        if (a.isZero() || b.isZero()) {
+            out.limbs.clear();
+            out.negative = false;
+            return;
+        }
+        Workspace& ws = threadWorkspace();
+        ws.prod.resize(a.limbs.size() + b.limbs.size());
+        mulLimbs(a.limbs.data(), a.limbs.size(), b.limbs.data(), b.limbs.size(), ws.prod.data());
+        modLimbs(ws.prod.data(), ws.prod.size(), a.negative != b.negative, m, out, ws);
+    }
+
+    // 移位运算（作用于绝对值）
+    BigInt operator<<(size_t bits) const {
+        if (isZero()) return *this;
+        size_t limbShift = bits / LIMB_BITS;
+        int bitShift = bits % LIMB_BITS;
+        BigInt result;
+        result.negative = negative;
+        result.limbs.assign(limbs.size() + limbShift + 1, 0);
+        for (size_t i = 0; i < limbs.size(); ++i) {
+            result.limbs[i + limbShift] |= limbs[i] << bitShift;
+            if (bitShift) result.limbs[i + limbShift + 1] = limbs[i] >> (LIMB_BITS - bitShift);
+        }
+        result.trim();
+        return result;
+    }
+
+    BigInt operator>>(size_t bits) const {
+        size_t limbShift = bits / LIMB_BITS;
+        int bitShift = bits % LIMB_BITS;
+        BigInt result;
+        if (limbShift >= limbs.size()) return result;
+        result.negative = negative;
+        result.limbs.assign(limbs.size() - limbShift, 0);
+        for (size_t i = 0; i < result.limbs.size(); ++i) {
+            result.limbs[i] = limbs[i + limbShift] >> bitShift;
+            if (bitShift && i + limbShift + 1 < limbs.size())
+                result.limbs[i] |= limbs[i + limbShift + 1] << (LIMB_BITS - bitShift);
         }
+        result.trim();
         return result;
     }
 
-    // Ƚ
+    BigInt& operator<<=(size_t bits) {
+        *this = *this << bits;
+        return *this;
+    }
+
+    BigInt& operator>>=(size_t bits) {
+        size_t limbShift = bits / LIMB_BITS;
+        int bitShift = bits % LIMB_BITS;
+        if (limbShift >= limbs.size()) {
+            limbs.clear();
+            negative = false;
+            return *this;
+        }
+        size_t n = limbs.size() - limbShift;
+        for (size_t i = 0; i < n; ++i) {
+            limbs[i] = limbs[i + limbShift] >> bitShift;
+            if (bitShift && i + limbShift + 1 < limbs.size())
+                limbs[i] |= limbs[i + limbShift + 1] << (LIMB_BITS - bitShift);
+        }
+        limbs.resize(n);
+        trim();
+        return *this;
+    }
+
+    // 比较运算符
     bool operator==(const BigInt& other) const {
-        return negative == other.negative && digits == other.digits;
+        return negative == other.negative && limbs == other.limbs;
     }
 
     bool operator!=(const BigInt& other) const {
@@ -96,95 +473,274 @@ public:
 
     bool operator<(const BigInt& other) const {
         if (negative != other.negative) return negative;
-        if (digits.size() != other.digits.size()) 
-            return negative ? digits.size() > other.digits.size() : digits.size() < other.digits.size();
-        for (size_t i = digits.size(); i-- > 0;) {
-            if (digits[i] != other.digits[i])
-                return negative ? digits[i] > other.digits[i] : digits[i] < other.digits[i];
-        }
-        return false;
+        int cmp = compareAbs(*this, other);
+        return negative ? cmp > 0 : cmp < 0;
     }
 
     bool operator<=(const BigInt& other) const {
-        return *this < other || *this == other;
+        return !(other < *this);
     }
 
     bool operator>(const BigInt& other) const {
-        return !(*this <= other);
+        return other < *this;
     }
 
     bool operator>=(const BigInt& other) const {
         return !(*this < other);
     }
 
-    // ģ (a^b mod m)
-    static BigInt modPow(const BigInt& base, const BigInt& exp, const BigInt& mod) {
-        if (mod == BigInt(1)) return BigInt(0);
-        
-        BigInt result(1);
-        BigInt b = base % mod;
-        BigInt e = exp;
-        
-        while (e > BigInt(0)) {
-            if (e.digits[0] % 2 == 1) {
-                result = (result * b) % mod;
-            }
-            e = e / BigInt(2);
-            b = (b * b) % mod;
-        }
-        
-        return result;
+    // 与小整数常量比较，不构造临时 BigInt
+    bool operator==(long long v) const { return compareSmall(v) == 0; }
+    bool operator!=(long long v) const { return compareSmall(v) != 0; }
+    bool operator<(long long v) const { return compareSmall(v) < 0; }
+    bool operator<=(long long v) const { return compareSmall(v) <= 0; }
+    bool operator>(long long v) const { return compareSmall(v) > 0; }
+    bool operator>=(long long v) const { return compareSmall(v) >= 0; }
+
+    // 符号：负数 -1，零 0，正数 1
+    int sign() const {
+        return limbs.empty() ? 0 : (negative ? -1 : 1);
+    }
+
+    bool isOne() const {
+        return !negative && limbs.size() == 1 && limbs[0] == 1;
     }
 
-    // Լ
+    // 模幂运算 (a^b mod m)，奇数模数自动走 Montgomery 约简
+    static BigInt modPow(const BigInt& base, const BigInt& exp, const BigInt& mod);
+
+    // 模幂运算，复用预先构建的 Montgomery 上下文
+    static BigInt modPow(const BigInt& base, const BigInt& exp, const MontgomeryContext& ctx);
+
+    // 最大公约数
     static BigInt gcd(BigInt a, BigInt b) {
         a.negative = false;
         b.negative = false;
-        while (b != BigInt(0)) {
-            BigInt temp = b;
-            b = a % b;
-            a = temp;
+        while (!b.isZero()) {
+            a %= b;
+            a.swap(b);
         }
         return a;
     }
 
-    // չŷ㷨
+    // 扩展欧几里得算法
     static BigInt modInverse(const BigInt& a, const BigInt& m) {
-        BigInt m0 = m;
+        if (m.isOne()) return BigInt();
+
         BigInt x0(0), x1(1);
-        
-        if (m == BigInt(1)) return BigInt(0);
-        
         BigInt aa = a;
         BigInt mm = m;
-        
-        while (aa > BigInt(1)) {
-            BigInt q = aa / mm;
-            BigInt t = mm;
-            
-            mm = aa % mm;
-            aa = t;
-            
-            t = x0;
-            x0 = x1 - q * x0;
-            x1 = t;
-        }
-        
-        if (x1 < BigInt(0)) x1 = x1 + m0;
-        
+        BigInt q, r;
+        Workspace& ws = threadWorkspace();
+
+        while (aa > 1) {
+            // 一次除法同时得到商和余数：(aa, mm) <- (mm, aa mod mm)
+            divModInto(aa, mm, &q, r, ws);
+            aa.swap(mm);
+            mm.swap(r);
+
+            // (x0, x1) <- (x1 - q * x0, x0)
+            q *= x0;
+            x1 -= q;
+            x0.swap(x1);
+        }
+
+        if (x1.sign() < 0) x1 += m;
+
         return x1;
     }
 
-    // תΪַ
+    // 十进制表示的长度上限（含负号），用于预先分配输出缓冲区
+    size_t decimalLengthBound() const {
+        return bitLength() * 1234 / 4096 + 2; // 1234/4096 > log10(2)
+    }
+
+    // 把十进制表示写入 out，返回写入末尾；out 至少要有 decimalLengthBound() 个字符
+    char* toChars(char* out) const {
+        if (negative) *out++ = '-';
+        return writeDecimal(*this, out);
+    }
+
+    // 把十进制表示追加到 out 末尾，只在必要时扩容一次
+    void appendTo(std::string& out) const {
+        size_t old = out.size();
+        out.resize(old + decimalLengthBound());
+        char* end = toChars(&out[old]);
+        out.resize(end - out.data());
+    }
+
+    // 转换为十进制字符串：较短的数每次取出 10^19 一组十进制位，
+    // 较长的数按缓存的 10^(19*2^k) 分治，见 writeDecimal
     std::string toString() const {
         std::string result;
-        if (negative && !(digits.size() == 1 && digits[0] == 0)) result += "-";
-        for (size_t i = digits.size(); i-- > 0;) result += char('0' + digits[i]);
+        appendTo(result);
+        return result;
+    }
+
+    // 由十进制字符 [first, last) 构造，可带前导 '-'，其它非数字字符被忽略
+    static BigInt fromDecimal(const char* first, const char* last) {
+        BigInt result;
+        result.parseDecimal(first, last);
+        return result;
+    }
+
+    // 小写十六进制表示（无 0x 前缀）
+    std::string toHexString() const {
+        if (isZero()) return "0";
+        static const char HEX[] = "0123456789abcdef";
+        std::string result(limbs.size() * 16 + (negative ? 1 : 0), '0');
+        char* p = &result[0] + result.size();
+        for (size_t i = 0; i < limbs.size(); ++i) {
+            Limb v = limbs[i];
+            for (int j = 0; j < 16; ++j, v >>= 4) *--p = HEX[v & 15];
+        }
+        size_t skip = 0;
+        size_t start = negative ? 1 : 0;
+        while (result[start + skip] == '0') ++skip;
+        result.erase(start, skip);
+        if (negative) result[0] = '-';
+        return result;
+    }
+
+    // 由十六进制字符串构造，可带前导 '-' 和 "0x" 前缀，大小写均可
+    static BigInt fromHexString(const std::string& hex) {
+        BigInt result;
+        size_t i = 0;
+        bool neg = false;
+        if (i < hex.size() && hex[i] == '-') {
+            neg = true;
+            ++i;
+        }
+        if (i + 1 < hex.size() && hex[i] == '0' && (hex[i + 1] == 'x' || hex[i + 1] == 'X')) i += 2;
+        size_t digits = hex.size() - i;
+        result.limbs.assign((digits + 15) / 16, 0);
+        for (size_t pos = 0; pos < digits; ++pos) {
+            char c = hex[hex.size() - 1 - pos];
+            Limb v;
+            if (c >= '0' && c <= '9') v = c - '0';
+            else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+            else throw std::invalid_argument("invalid hex digit");
+            result.limbs[pos / 16] |= v << (4 * (pos % 16));
+        }
+        result.negative = neg;
+        result.trim();
         return result;
     }
 
     bool isZero() const {
-        return digits.size() == 1 && digits[0] == 0;
+        return limbs.empty();
+    }
+
+    bool isOdd() const {
+        return !limbs.empty() && (limbs[0] & 1);
+    }
+
+    void setBit(size_t i) {
+        size_t idx = i / LIMB_BITS;
+        if (idx >= limbs.size()) limbs.resize(idx + 1, 0);
+        limbs[idx] |= (Limb)1 << (i % LIMB_BITS);
+    }
+
+    // [0, 2^bits) 内的均匀随机数；gen 每次需产生 64 位随机数（如 std::mt19937_64）
+    template <typename URBG>
+    static BigInt random(size_t bits, URBG& gen) {
+        BigInt result;
+        result.limbs.resize((bits + LIMB_BITS - 1) / LIMB_BITS);
+        for (Limb& limb : result.limbs) limb = (Limb)gen();
+        if (bits % LIMB_BITS) result.limbs.back() &= ((Limb)1 << (bits % LIMB_BITS)) - 1;
+        result.trim();
+        return result;
+    }
+
+    // [min, max] 内的均匀随机数（拒绝采样，平均不超过两次）
+    template <typename URBG>
+    static BigInt randomRange(const BigInt& min, const BigInt& max, URBG& gen) {
+        if (max < min) throw std::invalid_argument("randomRange: max < min");
+        BigInt span = max - min;
+        size_t bits = span.bitLength();
+        BigInt r;
+        do {
+            r = random(bits, gen);
+        } while (r > span);
+        return min + r;
+    }
+
+    // 绝对值的低 64 位
+    uint64_t toUint64() const {
+        return limbs.empty() ? 0 : limbs[0];
+    }
+
+    // 绝对值对单个 limb 取模（不修改自身）
+    Limb modSmall(Limb d) const {
+        DLimb rem = 0;
+        for (size_t i = limbs.size(); i-- > 0;) {
+            rem = ((rem << LIMB_BITS) | limbs[i]) % d;
+        }
+        return (Limb)rem;
+    }
+
+    // 二进制位数（0 的位数为 0）
+    size_t bitLength() const {
+        if (limbs.empty()) return 0;
+        return (limbs.size() - 1) * LIMB_BITS + (LIMB_BITS - __builtin_clzll(limbs.back()));
+    }
+
+    bool testBit(size_t i) const {
+        size_t idx = i / LIMB_BITS;
+        if (idx >= limbs.size()) return false;
+        return (limbs[idx] >> (i % LIMB_BITS)) & 1;
+    }
+
+    // 由大端字节序构造非负整数
+    static BigInt fromBytes(const unsigned char* data, size_t len) {
+        BigInt result;
+        result.limbs.assign((len + 7) / 8, 0);
+        for (size_t i = 0; i < len; ++i) {
+            size_t pos = len - 1 - i; // 从最低字节开始
+            result.limbs[i / 8] |= (Limb)data[pos] << (8 * (i % 8));
+        }
+        result.trim();
+        return result;
+    }
+
+    // 以定长大端字节序写出绝对值：不足 len 字节时高位补零，超出部分截断
+    void toBytes(unsigned char* out, size_t len) const {
+        for (size_t i = 0; i < len; ++i) {
+            size_t idx = i / 8;
+            Limb limb = idx < limbs.size() ? limbs[idx] : 0;
+            out[len - 1 - i] = (unsigned char)(limb >> (8 * (i % 8)));
+        }
+    }
+
+    // 绝对值的 limb 个数
+    size_t limbCount() const {
+        return limbs.size();
+    }
+
+    // 由 count 个小端 64 位 limb（低位 limb 在前）构造非负整数。
+    // 小端主机上直接整段复制，不做任何进制转换
+    static BigInt fromLittleEndianLimbs(const unsigned char* data, size_t count) {
+        BigInt result;
+        result.limbs.resize(count);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (count) std::memcpy(result.limbs.data(), data, count * sizeof(Limb));
+#else
+        for (size_t i = 0; i < count; ++i) {
+            Limb limb = 0;
+            for (int b = 7; b >= 0; --b) limb = (limb << 8) | data[i * 8 + b];
+            result.limbs[i] = limb;
+        }
+#endif
+        result.trim();
+        return result;
+    }
+
+    // 以小端 limb 序写出绝对值，共 limbCount() * 8 字节
+    void toLittleEndianLimbs(unsigned char* out) const {
+        for (size_t i = 0; i < limbs.size(); ++i) {
+            for (int b = 0; b < 8; ++b) out[i * 8 + b] = (unsigned char)(limbs[i] >> (8 * b));
+        }
     }
 
     friend std::ostream& operator<<(std::ostream& os, const BigInt& num) {
@@ -193,123 +749,914 @@ public:
     }
 
 private:
-    std::vector<int> digits; // 洢ÿλ0-9
+    friend class MontgomeryContext;
+    friend class LimbArena::Scope;
+
+    // 除法和模乘的可复用临时空间（规格化后的被除数、除数、乘积，以及分治乘法的递归草稿区）。
+    // 只通过 threadWorkspace() 按线程使用，LimbArena::Scope 回退前会清掉其中来自分配区的缓冲区。
+    struct Workspace {
+        LimbVector num, den, prod, mul;
+    };
+
+    // 当前线程的临时空间
+    static Workspace& threadWorkspace() {
+        thread_local Workspace ws;
+        return ws;
+    }
+
+    LimbVector limbs;        // 小端存储，每个元素一个64位limb，无前导零；0 为空
     bool negative;
 
-    void fromString(const std::string& num) {
-        digits.clear();
-        negative = false;
-        size_t i = 0;
-        if (num.empty()) {
-            digits.push_back(0);
+    static constexpr Limb DEC_CHUNK = 10000000000000000000ULL; // 10^19
+    static constexpr size_t DEC_CHUNK_DIGITS = 19;
+
+    // 切换到分治算法的阈值。输出按 limb 数：Barrett 拆分只需乘法，很早就比逐组单 limb 除法快；
+    // 输入按十进制位数（约 64 个 limb）：拼接依赖 Karatsuba 乘法，更短时分块累乘更快
+    static constexpr size_t DEC_DC_LIMBS = 16;
+    static constexpr size_t DEC_DC_DIGITS = 64 * DEC_CHUNK_DIGITS * 64 / 63;
+
+    // 缓存的 P = 10^(19*2^k)（first）及其 Barrett 倒数 floor(B^(2m) / P)（second），m 为 P 的 limb 个数。
+    // 按需生成；deque 追加元素不会使已返回的引用失效
+    static const std::pair<BigInt, BigInt>& decimalPower(size_t k) {
+        static std::deque<std::pair<BigInt, BigInt>> cache;
+        static std::mutex cacheMutex;
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        while (cache.size() <= k) {
+            BigInt value;
+            if (cache.empty()) {
+                value.limbs.push_back(DEC_CHUNK);
+            } else {
+                value = cache.back().first * cache.back().first;
+            }
+            BigInt inverse = (BigInt(1) << (2 * LIMB_BITS * value.limbs.size())) / value;
+            // 缓存长期保留：即使调用方处于 LimbArena::Scope 中，也复制一份到堆上
+            LimbArena::Suspend suspend;
+            cache.emplace_back(BigInt(value), BigInt(inverse));
+        }
+        return cache[k];
+    }
+
+    // Barrett 约简：x = q * P + r（0 <= r < P，P = 10^(19*2^k)），要求 0 <= x < P^2
+    static void splitDecimal(const BigInt& x, size_t k, BigInt& q, BigInt& r) {
+        const std::pair<BigInt, BigInt>& pw = decimalPower(k);
+        const BigInt& p = pw.first;
+        size_t m = p.limbs.size();
+        q = x >> (LIMB_BITS * (m - 1));
+        q *= pw.second;
+        q >>= LIMB_BITS * (m + 1);
+        r = q;
+        r *= p;
+        r = x - r;
+        while (r >= p) {
+            r -= p;
+            q += BigInt(1);
+        }
+    }
+
+    // 写出 |x| 的十进制表示（无前导零），返回写入末尾
+    static char* writeDecimal(const BigInt& x, char* out) {
+        if (x.limbs.size() < DEC_DC_LIMBS) return writeDecimalChunked(x, out, 0);
+        // 取最大的 k 使 P = 10^(19*2^k) <= |x|，此时 |x| < P^2：高半部分递归，低半部分补零到固定宽度
+        size_t k = 0;
+        while (decimalPower(k + 1).first.limbs.size() < x.limbs.size()) ++k;
+        if (compareAbs(decimalPower(k + 1).first, x) <= 0) ++k;
+        BigInt ax = x;
+        ax.negative = false;
+        BigInt q, r;
+        splitDecimal(ax, k, q, r);
+        out = writeDecimal(q, out);
+        size_t width = DEC_CHUNK_DIGITS << k;
+        writeDecimalPadded(r, out, width, k);
+        return out + width;
+    }
+
+    // 写出恰好 width = 19*2^k 位（高位补零），要求 0 <= x < 10^width
+    static void writeDecimalPadded(const BigInt& x, char* out, size_t width, size_t k) {
+        if (x.limbs.size() < DEC_DC_LIMBS || k == 0) {
+            writeDecimalChunked(x, out, width);
             return;
         }
-        if (num[0] == '-') {
+        BigInt q, r;
+        splitDecimal(x, k - 1, q, r);
+        writeDecimalPadded(q, out, width / 2, k - 1);
+        writeDecimalPadded(r, out + width / 2, width / 2, k - 1);
+    }
+
+    // 逐次除以 10^19 的分块转换。width > 0 时恰好写 width 位（高位补零），否则不补零；返回写入末尾
+    static char* writeDecimalChunked(const BigInt& x, char* out, size_t width) {
+        BigInt cur = x;
+        cur.negative = false;
+        if (width > 0) {
+            char* p = out + width;
+            while (!cur.isZero() && p > out) {
+                Limb chunk = cur.divModSmall(DEC_CHUNK);
+                size_t n = std::min<size_t>(DEC_CHUNK_DIGITS, p - out);
+                p -= n;
+                writeDigits(chunk, p, n);
+            }
+            std::fill(out, p, '0');
+            return out + width;
+        }
+        if (cur.isZero()) {
+            *out = '0';
+            return out + 1;
+        }
+        // 先从低位收集各组，再从高位写出
+        Limb chunks[DEC_DC_LIMBS * 64 / 63 + 2];
+        size_t count = 0;
+        while (!cur.isZero()) chunks[count++] = cur.divModSmall(DEC_CHUNK);
+        size_t top = 0;
+        for (Limb v = chunks[count - 1]; v; v /= 10) ++top;
+        writeDigits(chunks[count - 1], out, top);
+        out += top;
+        for (size_t i = count - 1; i-- > 0;) {
+            writeDigits(chunks[i], out, DEC_CHUNK_DIGITS);
+            out += DEC_CHUNK_DIGITS;
+        }
+        return out;
+    }
+
+    // 把 v 的低 n 位十进制数写到 out[0, n)，不足补零
+    static void writeDigits(Limb v, char* out, size_t n) {
+        for (size_t i = n; i-- > 0;) {
+            out[i] = char('0' + v % 10);
+            v /= 10;
+        }
+    }
+
+    void fromString(const std::string& num) {
+        parseDecimal(num.data(), num.data() + num.size());
+    }
+
+    void parseDecimal(const char* first, const char* last) {
+        limbs.clear();
+        negative = false;
+        if (first == last) return;
+        if (*first == '-') {
             negative = true;
-            i = 1;
+            ++first;
+        }
+        // 非数字字符被忽略：只在确实存在时才复制出纯数字串
+        std::string digitsOnly;
+        if (std::find_if(first, last, [](char c) { return !isdigit((unsigned char)c); }) != last) {
+            for (const char* p = first; p != last; ++p) {
+                if (isdigit((unsigned char)*p)) digitsOnly += *p;
+            }
+            first = digitsOnly.data();
+            last = first + digitsOnly.size();
         }
-        for (size_t j = num.size(); j > i; --j) {
-            if (isdigit(num[j - 1])) digits.push_back(num[j - 1] - '0');
+        bool neg = negative;
+        parseDigits(first, last);
+        negative = neg;
+        trim();
+    }
+
+    // 纯数字串 -> 绝对值。较长的串按 19*2^k 位切分：value = high * 10^(19*2^k) + low
+    void parseDigits(const char* first, const char* last) {
+        size_t len = last - first;
+        if (len < DEC_DC_DIGITS) {
+            parseDigitsChunked(first, last);
+            return;
+        }
+        size_t k = 0;
+        while ((DEC_CHUNK_DIGITS << (k + 1)) < len) ++k;
+        size_t lowLen = DEC_CHUNK_DIGITS << k;
+        BigInt low;
+        low.parseDigits(last - lowLen, last);
+        parseDigits(first, last - lowLen);
+        negative = false;
+        *this *= decimalPower(k).first;
+        *this += low;
+    }
+
+    // 每 19 位十进制为一组：value = value * 10^k + chunk
+    void parseDigitsChunked(const char* first, const char* last) {
+        limbs.clear();
+        negative = false;
+        Limb chunk = 0, scale = 1;
+        int count = 0;
+        for (const char* p = first; p != last; ++p) {
+            chunk = chunk * 10 + (*p - '0');
+            scale *= 10;
+            if (++count == (int)DEC_CHUNK_DIGITS) {
+                mulAddSmall(scale, chunk);
+                chunk = 0;
+                scale = 1;
+                count = 0;
+            }
         }
-        if (digits.empty()) digits.push_back(0);
+        if (count > 0) mulAddSmall(scale, chunk);
         trim();
     }
 
     void fromLongLong(long long num) {
-        digits.clear();
+        limbs.clear();
         negative = num < 0;
-        if (num == 0) {
-            digits.push_back(0);
+        if (num == 0) return;
+        // 取绝对值时避免 LLONG_MIN 溢出
+        Limb mag = negative ? (Limb)0 - (Limb)num : (Limb)num;
+        limbs.push_back(mag);
+    }
+
+    // *this = *this * mul + add（仅作用于绝对值）
+    // 循环内使用局部指针：Limb 与 size_t 类型相同，直接写 limbs[i] 会迫使编译器每轮重新读取长度
+    void mulAddSmall(Limb mul, Limb add) {
+        Limb carry = add;
+        Limb* p = limbs.data();
+        size_t n = limbs.size();
+        for (size_t i = 0; i < n; ++i) {
+            DLimb cur = (DLimb)p[i] * mul + carry;
+            p[i] = (Limb)cur;
+            carry = (Limb)(cur >> LIMB_BITS);
+        }
+        if (carry) limbs.push_back(carry);
+    }
+
+    // *this /= d（仅作用于绝对值），返回余数
+    Limb divModSmall(Limb d) {
+        DLimb rem = 0;
+        Limb* p = limbs.data();
+        for (size_t i = limbs.size(); i-- > 0;) {
+            DLimb cur = (rem << LIMB_BITS) | p[i];
+            p[i] = (Limb)(cur / d);
+            rem = cur % d;
+        }
+        trim();
+        return (Limb)rem;
+    }
+
+    static size_t mulThreshold() {
+        return std::max<size_t>(karatsubaThreshold, 2);
+    }
+
+    // out[0, an+bn) = a * b，out 不能与输入重叠。
+    // 分治乘法的临时空间整次乘法一次性从线程 Workspace 取，递归过程中不再分配
+    static void mulLimbs(const Limb* a, size_t an, const Limb* b, size_t bn, Limb* out) {
+        if (std::min(an, bn) < mulThreshold()) {
+            mulLimbs(a, an, b, bn, out, nullptr);
+            return;
+        }
+        LimbVector& scratch = threadWorkspace().mul;
+        scratch.reserve(mulScratchLimbs(an, bn));
+        mulLimbs(a, an, b, bn, out, scratch.data());
+    }
+
+    // 与调用结构一一对应地计算 mulLimbs 递归所需的草稿区 limb 数
+    static size_t mulScratchLimbs(size_t an, size_t bn) {
+        if (an < bn) std::swap(an, bn);
+        if (bn < mulThreshold()) return 0;
+        if (an == bn) {
+            size_t hi = an - an / 2;
+            return 6 * hi + 1 + mulScratchLimbs(hi, hi);
+        }
+        size_t need = mulScratchLimbs(bn, bn);
+        if (an % bn) need = std::max(need, mulScratchLimbs(bn, an % bn));
+        return 2 * bn + need;
+    }
+
+    // scratch 至少有 mulScratchLimbs(an, bn) 个 limb
+    static void mulLimbs(const Limb* a, size_t an, const Limb* b, size_t bn, Limb* out, Limb* scratch) {
+        if (an < bn) {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+        if (bn < mulThreshold()) {
+            mulBasecase(a, an, b, bn, out);
             return;
         }
-        if (negative) num = -num;
-        while (num > 0) {
-            digits.push_back(num % 10);
-            num /= 10;
+        if (an == bn) {
+            mulKaratsuba(a, b, an, out, scratch);
+            return;
+        }
+        // 长度不平衡：把长操作数切成 bn 大小的块分别相乘再累加
+        std::fill(out, out + an + bn, 0);
+        Limb* partial = scratch;
+        for (size_t off = 0; off < an; off += bn) {
+            size_t len = std::min(bn, an - off);
+            mulLimbs(a + off, len, b, bn, partial, scratch + 2 * bn);
+            addLimbs(out + off, an + bn - off, partial, len + bn);
+        }
+    }
+
+    // 小学乘法 O(an * bn)
+    static void mulBasecase(const Limb* a, size_t an, const Limb* b, size_t bn, Limb* out) {
+        std::fill(out, out + an + bn, 0);
+        for (size_t i = 0; i < an; ++i) {
+            Limb carry = 0;
+            for (size_t j = 0; j < bn; ++j) {
+                DLimb cur = (DLimb)a[i] * b[j] + out[i + j] + carry;
+                out[i + j] = (Limb)cur;
+                carry = (Limb)(cur >> LIMB_BITS);
+            }
+            out[i + bn] = carry;
+        }
+    }
+
+    // Karatsuba（减法形式）：a = a1*B^h + a0, b = b1*B^h + b0
+    // a*b = z2*B^2h + (z0 + z2 + (a0-a1)(b1-b0))*B^h + z0
+    // scratch 依次存放 da[hi]、db[hi]、mid[2hi]、t[2hi+1]，其后留给递归调用
+    static void mulKaratsuba(const Limb* a, const Limb* b, size_t n, Limb* out, Limb* scratch) {
+        size_t h = n / 2;
+        size_t hi = n - h;
+        Limb* da = scratch;
+        Limb* db = da + hi;
+        Limb* mid = db + hi;
+        Limb* t = mid + 2 * hi;
+        size_t tn = 2 * hi + 1;
+        Limb* rest = t + tn;
+
+        mulLimbs(a, h, b, h, out, rest);                  // z0 -> out[0, 2h)
+        mulLimbs(a + h, hi, b + h, hi, out + 2 * h, rest); // z2 -> out[2h, 2n)
+
+        bool negA = absDiffLimbs(a, h, a + h, hi, da);  // |a0 - a1|
+        bool negB = absDiffLimbs(b + h, hi, b, h, db);  // |b1 - b0|
+        mulLimbs(da, hi, db, hi, mid, rest);
+
+        std::copy(out, out + 2 * h, t);
+        std::fill(t + 2 * h, t + tn, 0);
+        addLimbs(t, tn, out + 2 * h, 2 * hi);
+        if (negA == negB) addLimbs(t, tn, mid, 2 * hi);
+        else subLimbs(t, tn, mid, 2 * hi);
+
+        addLimbs(out + h, 2 * n - h, t, tn);
+    }
+
+    // dst[0, dn) += src[0, sn)，要求 dn >= sn 且结果不溢出 dn
+    static void addLimbs(Limb* dst, size_t dn, const Limb* src, size_t sn) {
+        Limb carry = 0;
+        size_t i = 0;
+        for (; i < sn; ++i) {
+            DLimb sum = (DLimb)dst[i] + src[i] + carry;
+            dst[i] = (Limb)sum;
+            carry = (Limb)(sum >> LIMB_BITS);
+        }
+        for (; carry && i < dn; ++i) {
+            carry = (++dst[i] == 0) ? 1 : 0;
+        }
+    }
+
+    // dst[0, dn) -= src[0, sn)，要求 dst >= src
+    static void subLimbs(Limb* dst, size_t dn, const Limb* src, size_t sn) {
+        Limb borrow = 0;
+        size_t i = 0;
+        for (; i < sn; ++i) {
+            Limb s = src[i];
+            Limb d = dst[i];
+            dst[i] = d - s - borrow;
+            borrow = (d < s || (d - s) < borrow) ? 1 : 0;
+        }
+        for (; borrow && i < dn; ++i) {
+            borrow = (dst[i]-- == 0) ? 1 : 0;
         }
     }
 
+    // out[0, max(xn, yn)) = |x - y|，返回 x < y
+    static bool absDiffLimbs(const Limb* x, size_t xn, const Limb* y, size_t yn, Limb* out) {
+        size_t m = std::max(xn, yn);
+        int cmp = 0;
+        for (size_t i = m; i-- > 0 && cmp == 0;) {
+            Limb xi = i < xn ? x[i] : 0;
+            Limb yi = i < yn ? y[i] : 0;
+            if (xi != yi) cmp = xi < yi ? -1 : 1;
+        }
+        if (cmp < 0) {
+            std::swap(x, y);
+            std::swap(xn, yn);
+        }
+        std::fill(out, out + m, 0);
+        std::copy(x, x + xn, out);
+        subLimbs(out, m, y, yn);
+        return cmp < 0;
+    }
+
     static BigInt addAbs(const BigInt& a, const BigInt& b) {
+        const BigInt& longer = a.limbs.size() >= b.limbs.size() ? a : b;
+        const BigInt& shorter = a.limbs.size() >= b.limbs.size() ? b : a;
         BigInt result;
-        result.digits.clear();
-        int carry = 0;
-        size_t i = 0;
-        while (i < a.digits.size() || i < b.digits.size() || carry) {
-            int sum = carry;
-            if (i < a.digits.size()) sum += a.digits[i];
-            if (i < b.digits.size()) sum += b.digits[i];
-            result.digits.push_back(sum % 10);
-            carry = sum / 10;
-            ++i;
+        result.limbs.resize(longer.limbs.size() + 1);
+        Limb carry = 0;
+        for (size_t i = 0; i < longer.limbs.size(); ++i) {
+            DLimb sum = (DLimb)longer.limbs[i] + carry;
+            if (i < shorter.limbs.size()) sum += shorter.limbs[i];
+            result.limbs[i] = (Limb)sum;
+            carry = (Limb)(sum >> LIMB_BITS);
         }
-        return result.trim();
+        result.limbs[longer.limbs.size()] = carry;
+        result.trim();
+        return result;
     }
 
+    // 要求 |a| >= |b|
     static BigInt subAbs(const BigInt& a, const BigInt& b) {
         BigInt result;
-        result.digits.clear();
-        int borrow = 0;
-        size_t i = 0;
-        while (i < a.digits.size()) {
-            int diff = a.digits[i] - borrow;
-            if (i < b.digits.size()) diff -= b.digits[i];
-            if (diff < 0) {
-                diff += 10;
-                borrow = 1;
+        result.limbs.resize(a.limbs.size());
+        Limb borrow = 0;
+        for (size_t i = 0; i < a.limbs.size(); ++i) {
+            Limb sub = i < b.limbs.size() ? b.limbs[i] : 0;
+            Limb diff = a.limbs[i] - sub - borrow;
+            borrow = (a.limbs[i] < sub || (a.limbs[i] - sub) < borrow) ? 1 : 0;
+            result.limbs[i] = diff;
+        }
+        result.trim();
+        return result;
+    }
+
+    // 比较绝对值：返回 -1, 0, 1
+    static int compareAbs(const BigInt& a, const BigInt& b) {
+        return compareLimbs(a.limbs.data(), a.limbs.size(), b.limbs.data(), b.limbs.size());
+    }
+
+    static bool absGreaterOrEqual(const BigInt& a, const BigInt& b) {
+        return compareAbs(a, b) >= 0;
+    }
+
+    // |a| += |b|，a 与 b 可以是同一个缓冲区
+    static void addMagnitude(LimbVector& a, const LimbVector& b) {
+        size_t bn = b.size();
+        size_t n = std::max(a.size(), bn);
+        a.resize(n + 1, 0);
+        Limb carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            DLimb sum = (DLimb)a[i] + carry;
+            if (i < bn) sum += b[i];
+            a[i] = (Limb)sum;
+            carry = (Limb)(sum >> LIMB_BITS);
+        }
+        a[n] = carry;
+    }
+
+    // |a| -= |b|，要求 |a| >= |b|
+    static void subMagnitude(LimbVector& a, const LimbVector& b) {
+        subLimbs(a.data(), a.size(), b.data(), b.size());
+    }
+
+    // |a| = |b| - |a|，要求 |b| >= |a|
+    static void reverseSubMagnitude(LimbVector& a, const LimbVector& b) {
+        size_t bn = b.size();
+        a.resize(bn, 0);
+        Limb borrow = 0;
+        for (size_t i = 0; i < bn; ++i) {
+            Limb s = a[i];
+            Limb d = b[i];
+            a[i] = d - s - borrow;
+            borrow = (d < s || (d - s) < borrow) ? 1 : 0;
+        }
+    }
+
+    static int compareLimbs(const Limb* a, size_t an, const Limb* b, size_t bn) {
+        if (an != bn) return an < bn ? -1 : 1;
+        for (size_t i = an; i-- > 0;) {
+            if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // 除法和取模：a = q*b + r（截断除法，余数与 a 同号）；quotient 为空指针时不计算商。
+    // 单 limb 除数走快速路径，否则用 Knuth 算法 D。
+    // 输出可以与输入为同一对象。
+    static void divModInto(const BigInt& a, const BigInt& b, BigInt* quotient, BigInt& remainder, Workspace& ws) {
+        if (b.isZero()) throw std::runtime_error("Division by zero");
+        bool qNeg = (a.negative != b.negative);
+        bool rNeg = a.negative;
+        divModLimbs(a.limbs.data(), a.limbs.size(), b.limbs.data(), b.limbs.size(),
+                    quotient ? &quotient->limbs : nullptr, remainder.limbs, ws);
+        if (quotient) {
+            quotient->negative = qNeg;
+            quotient->trim();
+        }
+        remainder.negative = rNeg;
+        remainder.trim();
+    }
+
+    // out = (±u) mod |m|，结果非负；out 不能是 m
+    static void modLimbs(const Limb* u, size_t un, bool neg, const BigInt& m, BigInt& out, Workspace& ws) {
+        divModLimbs(u, un, m.limbs.data(), m.limbs.size(), nullptr, out.limbs, ws);
+        out.negative = false;
+        out.trim();
+        if (neg && !out.isZero()) {
+            reverseSubMagnitude(out.limbs, m.limbs);
+            out.trim();
+        }
+    }
+
+    // 绝对值除法 u = q*v + r，v 无前导零且非空；q 为空指针时不保存商。
+    // 读完 u 和 v 之后才写出 q、r，因此它们可以与输入共用缓冲区。
+    static void divModLimbs(const Limb* u, size_t un, const Limb* v, size_t vn,
+                            LimbVector* q, LimbVector& r, Workspace& ws) {
+        while (un > 0 && u[un - 1] == 0) --un;
+
+        if (compareLimbs(u, un, v, vn) < 0) {
+            r.assign(u, un);
+            if (q) q->clear();
+            return;
+        }
+
+        if (vn == 1) {
+            Limb d = v[0];
+            DLimb rem = 0;
+            if (q) {
+                LimbVector& cur = ws.num;
+                cur.assign(u, un);
+                for (size_t i = un; i-- > 0;) {
+                    DLimb x = (rem << LIMB_BITS) | cur[i];
+                    cur[i] = (Limb)(x / d);
+                    rem = x % d;
+                }
+                q->takeFrom(cur);
             } else {
-                borrow = 0;
+                for (size_t i = un; i-- > 0;) rem = ((rem << LIMB_BITS) | u[i]) % d;
             }
-            result.digits.push_back(diff);
-            ++i;
+            r.clear();
+            if (rem) r.push_back((Limb)rem);
+            return;
         }
-        return result.trim();
+
+        divModKnuth(u, un, v, vn, q, r, ws);
     }
 
-    static bool absGreaterOrEqual(const BigInt& a, const BigInt& b) {
-        if (a.digits.size() != b.digits.size()) return a.digits.size() > b.digits.size();
-        for (size_t i = a.digits.size(); i-- > 0;) {
-            if (a.digits[i] != b.digits[i]) return a.digits[i] > b.digits[i];
-        }
-        return true;
-    }
-
-    // ȡģ
-    std::pair<BigInt, BigInt> divMod(const BigInt& divisor) const {
-        if (divisor.isZero()) throw std::runtime_error("Division by zero");
-        
-        BigInt dividend = *this;
-        dividend.negative = false;
-        BigInt div = divisor;
-        div.negative = false;
-        
-        if (dividend < div) {
-            return {BigInt(0), *this};
-        }
-        
-        BigInt quotient(0);
-        BigInt remainder(0);
-        
-        for (size_t i = dividend.digits.size(); i-- > 0;) {
-            remainder = remainder * BigInt(10) + BigInt(dividend.digits[i]);
-            
-            int count = 0;
-            while (remainder >= div) {
-                remainder = remainder - div;
-                count++;
+    // Knuth 算法 D（TAOCP 4.3.1）：u = q*v + r，要求 v 至少两个 limb 且 u >= v
+    static void divModKnuth(const Limb* u, size_t usize, const Limb* v, size_t n,
+                            LimbVector* q, LimbVector& r, Workspace& ws) {
+        size_t m = usize - n;
+        int s = __builtin_clzll(v[n - 1]);
+
+        // D1：规格化，使除数最高位为 1
+        LimbVector& vn = ws.den;
+        LimbVector& un = ws.num;
+        vn.resize(n);
+        un.resize(usize + 1);
+        for (size_t i = n - 1; i > 0; --i) {
+            vn[i] = (v[i] << s) | (s ? v[i - 1] >> (LIMB_BITS - s) : 0);
+        }
+        vn[0] = v[0] << s;
+        un[usize] = s ? u[usize - 1] >> (LIMB_BITS - s) : 0;
+        for (size_t i = usize - 1; i > 0; --i) {
+            un[i] = (u[i] << s) | (s ? u[i - 1] >> (LIMB_BITS - s) : 0);
+        }
+        un[0] = u[0] << s;
+
+        if (q) q->assign(m + 1, 0);
+        for (size_t j = m + 1; j-- > 0;) {
+            // D3：用最高两个 limb 估计商，至多偏大 2
+            DLimb num = ((DLimb)un[j + n] << LIMB_BITS) | un[j + n - 1];
+            DLimb qhat = num / vn[n - 1];
+            DLimb rhat = num % vn[n - 1];
+            while ((qhat >> LIMB_BITS) != 0 ||
+                   qhat * vn[n - 2] > ((rhat << LIMB_BITS) | un[j + n - 2])) {
+                --qhat;
+                rhat += vn[n - 1];
+                if ((rhat >> LIMB_BITS) != 0) break;
+            }
+
+            // D4：乘后相减 un[j, j+n] -= qhat * vn
+            Limb ql = (Limb)qhat;
+            Limb carry = 0, borrow = 0;
+            for (size_t i = 0; i < n; ++i) {
+                DLimb p = (DLimb)ql * vn[i] + carry;
+                carry = (Limb)(p >> LIMB_BITS);
+                Limb pl = (Limb)p;
+                Limb cur = un[i + j];
+                un[i + j] = cur - pl - borrow;
+                borrow = (cur < pl || (cur - pl) < borrow) ? 1 : 0;
+            }
+            Limb top = un[j + n];
+            un[j + n] = top - carry - borrow;
+            borrow = (top < carry || (top - carry) < borrow) ? 1 : 0;
+
+            // D6：估计值偏大时加回一次
+            if (borrow) {
+                --ql;
+                Limb c = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    DLimb sum = (DLimb)un[i + j] + vn[i] + c;
+                    un[i + j] = (Limb)sum;
+                    c = (Limb)(sum >> LIMB_BITS);
+                }
+                un[j + n] += c;
             }
-            
-            quotient.digits.insert(quotient.digits.begin(), count);
+            if (q) (*q)[j] = ql;
         }
-        
-        quotient.negative = (negative != divisor.negative);
-        remainder.negative = negative;
-        
-        return {quotient.trim(), remainder.trim()};
+
+        // D8：反规格化得到余数
+        r.assign(n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            r[i] = (un[i] >> s) | (s ? un[i + 1] << (LIMB_BITS - s) : 0);
+        }
+    }
+
+    // 与 v 比较：返回 -1, 0, 1
+    int compareSmall(long long v) const {
+        int s = v == 0 ? 0 : (v < 0 ? -1 : 1);
+        if (sign() != s) return sign() < s ? -1 : 1;
+        if (s == 0) return 0;
+        if (limbs.size() > 1) return s;
+        Limb mag = v < 0 ? (Limb)0 - (Limb)v : (Limb)v;
+        if (limbs[0] == mag) return 0;
+        return (limbs[0] < mag) == (s > 0) ? -1 : 1;
     }
 
     BigInt& trim() {
-        while (digits.size() > 1 && digits.back() == 0) digits.pop_back();
-        if (digits.size() == 1 && digits[0] == 0) negative = false;
+        while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+        if (limbs.empty()) negative = false;
         return *this;
     }
+
+    // 经典模幂（每步做一次完整除法），用于偶数模数
+    static BigInt modPowClassic(const BigInt& base, const BigInt& exp, const BigInt& mod) {
+        return windowedPow(base % mod, exp, BigInt(1),
+                           [&mod](const BigInt& a, const BigInt& b, BigInt& out) { mulMod(a, b, mod, out); });
+    }
+
+    // 根据指数位数选择滑动窗口宽度（与 OpenSSL 的阈值一致）
+    static int windowBitsForExponent(size_t bits) {
+        if (bits > 671) return 6;
+        if (bits > 239) return 5;
+        if (bits > 79) return 4;
+        if (bits > 23) return 3;
+        return 1;
+    }
+
+    // 从高位到低位扫描指数的滑动窗口模幂。
+    // mulInto(a, b, out) 为所在域上的乘法（out 与 a、b 不是同一对象），one 为该域中的 1；
+    // 预先计算奇数次幂 base^1, base^3, ..., base^(2^w - 1)。
+    template <typename MulInto>
+    static BigInt windowedPow(const BigInt& base, const BigInt& exp, const BigInt& one, MulInto mulInto) {
+        size_t bits = exp.bitLength();
+        if (bits == 0) return one;
+
+        int w = windowBitsForExponent(bits);
+        // 窗口最宽 6 位，奇数次幂表最多 32 项，放在栈上
+        BigInt table[32];
+        size_t tableSize = size_t(1) << (w - 1);
+        table[0] = base;
+        if (tableSize > 1) {
+            BigInt base2;
+            mulInto(base, base, base2);
+            for (size_t i = 1; i < tableSize; ++i) mulInto(table[i - 1], base2, table[i]);
+        }
+
+        // result 与 tmp 轮流作为输出，缓冲区容量稳定后循环中不再分配内存
+        BigInt result = one;
+        BigInt tmp;
+        bool started = false;
+        size_t i = bits;
+        while (i > 0) {
+            if (!exp.testBit(i - 1)) {
+                if (started) {
+                    mulInto(result, result, tmp);
+                    result.swap(tmp);
+                }
+                --i;
+                continue;
+            }
+            // 窗口 [j, i-1]，最低位 j 必须为 1
+            size_t j = i > (size_t)w ? i - w : 0;
+            while (!exp.testBit(j)) ++j;
+            size_t value = 0;
+            for (size_t b = i; b-- > j;) value = (value << 1) | (exp.testBit(b) ? 1 : 0);
+
+            if (started) {
+                for (size_t s = j; s < i; ++s) {
+                    mulInto(result, result, tmp);
+                    result.swap(tmp);
+                }
+                mulInto(result, table[value >> 1], tmp);
+                result.swap(tmp);
+            } else {
+                result = table[value >> 1];
+                started = true;
+            }
+            i = j;
+        }
+        return result;
+    }
 };
+
+// Montgomery 约简上下文：对固定的奇数模数 n 预计算 R = 2^(64k)、R mod n、R^2 mod n 和 n'，
+// 之后每次模乘只需乘法和移位，不再做除法。同一模数的多次模幂应复用同一个上下文。
+class MontgomeryContext {
+public:
+    using Limb = BigInt::Limb;
+    using DLimb = BigInt::DLimb;
+
+    explicit MontgomeryContext(const BigInt& modulus) : n(modulus) {
+        if (n.negative || !n.isOdd() || n.isOne()) {
+            throw std::invalid_argument("Montgomery modulus must be odd and greater than 1");
+        }
+        k = n.limbs.size();
+
+        // 牛顿迭代求 n0^-1 mod 2^64，每轮精度翻倍
+        Limb n0 = n.limbs[0];
+        Limb inv = n0;
+        for (int i = 0; i < 5; ++i) inv *= 2 - n0 * inv;
+        nPrime = (Limb)0 - inv;
+
+        BigInt r = BigInt(1) << (BigInt::LIMB_BITS * k);
+        rModN = r % n;
+        r2ModN = (rModN * rModN) % n;
+    }
+
+    const BigInt& modulus() const { return n; }
+
+    // 1 的 Montgomery 形式（即 R mod n）
+    const BigInt& one() const { return rModN; }
+
+    // a -> a*R mod n
+    BigInt toMontgomery(const BigInt& a) const {
+        if (a.negative || BigInt::compareAbs(a, n) >= 0) return multiply(a % n, r2ModN);
+        return multiply(a, r2ModN);
+    }
+
+    // a*R -> a mod n
+    BigInt fromMontgomery(const BigInt& a) const {
+        return multiply(a, BigInt(1));
+    }
+
+    // Montgomery 乘积 a*b*R^-1 mod n（要求 0 <= a, b < n）
+    BigInt multiply(const BigInt& a, const BigInt& b) const {
+        BigInt result;
+        multiply(a, b, result);
+        return result;
+    }
+
+    // 同上，结果写入 out 并复用其缓冲区；out 不能与 a 或 b 为同一对象
+    void multiply(const BigInt& a, const BigInt& b, BigInt& out) const {
+        // CIOS：逐个 limb 交替进行乘法与约简
+        LimbVector& t = out.limbs;
+        t.assign(k + 2, 0);
+        const LimbVector& al = a.limbs;
+        const LimbVector& bl = b.limbs;
+        const LimbVector& nl = n.limbs;
+
+        for (size_t i = 0; i < k; ++i) {
+            Limb bi = i < bl.size() ? bl[i] : 0;
+            Limb carry = 0;
+            if (bi) {
+                for (size_t j = 0; j < al.size(); ++j) {
+                    DLimb cur = (DLimb)al[j] * bi + t[j] + carry;
+                    t[j] = (Limb)cur;
+                    carry = (Limb)(cur >> BigInt::LIMB_BITS);
+                }
+                for (size_t j = al.size(); j < k && carry; ++j) {
+                    DLimb cur = (DLimb)t[j] + carry;
+                    t[j] = (Limb)cur;
+                    carry = (Limb)(cur >> BigInt::LIMB_BITS);
+                }
+            }
+            DLimb top = (DLimb)t[k] + carry;
+            t[k] = (Limb)top;
+            t[k + 1] += (Limb)(top >> BigInt::LIMB_BITS);
+
+            Limb m = t[0] * nPrime;
+            DLimb cur = (DLimb)m * nl[0] + t[0];
+            carry = (Limb)(cur >> BigInt::LIMB_BITS);
+            for (size_t j = 1; j < k; ++j) {
+                cur = (DLimb)m * nl[j] + t[j] + carry;
+                t[j - 1] = (Limb)cur;
+                carry = (Limb)(cur >> BigInt::LIMB_BITS);
+            }
+            cur = (DLimb)t[k] + carry;
+            t[k - 1] = (Limb)cur;
+            t[k] = t[k + 1] + (Limb)(cur >> BigInt::LIMB_BITS);
+            t[k + 1] = 0;
+        }
+
+        out.negative = false;
+        out.trim();
+        if (BigInt::compareAbs(out, n) >= 0) {
+            BigInt::subMagnitude(out.limbs, n.limbs);
+            out.trim();
+        }
+    }
+
+    BigInt square(const BigInt& a) const {
+        BigInt result;
+        square(a, result);
+        return result;
+    }
+
+    // Montgomery 平方 a*a*R^-1 mod n（要求 0 <= a < n），out 不能与 a 为同一对象。
+    // 先算完整平方（交叉项只乘一次再加倍），再逐 limb 约简，乘法次数约为 multiply 的 3/4
+    void square(const BigInt& a, BigInt& out) const {
+        LimbVector& t = out.limbs;
+        t.assign(2 * k + 1, 0);
+        const LimbVector& al = a.limbs;
+        const LimbVector& nl = n.limbs;
+        size_t len = al.size();
+
+        for (size_t i = 0; i + 1 < len; ++i) {
+            Limb carry = 0;
+            for (size_t j = i + 1; j < len; ++j) {
+                DLimb cur = (DLimb)al[i] * al[j] + t[i + j] + carry;
+                t[i + j] = (Limb)cur;
+                carry = (Limb)(cur >> BigInt::LIMB_BITS);
+            }
+            t[i + len] = carry;
+        }
+        Limb high = 0;
+        for (size_t i = 0; i < 2 * len; ++i) {
+            Limb v = t[i];
+            t[i] = (v << 1) | high;
+            high = v >> (BigInt::LIMB_BITS - 1);
+        }
+        Limb carry = 0;
+        for (size_t i = 0; i < len; ++i) {
+            DLimb cur = (DLimb)al[i] * al[i] + t[2 * i] + carry;
+            t[2 * i] = (Limb)cur;
+            cur = (DLimb)t[2 * i + 1] + (Limb)(cur >> BigInt::LIMB_BITS);
+            t[2 * i + 1] = (Limb)cur;
+            carry = (Limb)(cur >> BigInt::LIMB_BITS);
+        }
+
+        // 第 i 轮把 t[i] 消为 0，进位 extra 属于下一轮的 t[i + k + 1]
+        Limb extra = 0;
+        for (size_t i = 0; i < k; ++i) {
+            Limb m = t[i] * nPrime;
+            carry = 0;
+            for (size_t j = 0; j < k; ++j) {
+                DLimb cur = (DLimb)m * nl[j] + t[i + j] + carry;
+                t[i + j] = (Limb)cur;
+                carry = (Limb)(cur >> BigInt::LIMB_BITS);
+            }
+            DLimb cur = (DLimb)t[i + k] + carry + extra;
+            t[i + k] = (Limb)cur;
+            extra = (Limb)(cur >> BigInt::LIMB_BITS);
+        }
+        std::copy(t.begin() + k, t.begin() + 2 * k, t.begin());
+        t[k] = extra;
+        t.resize(k + 1);
+
+        out.negative = false;
+        out.trim();
+        if (BigInt::compareAbs(out, n) >= 0) {
+            BigInt::subMagnitude(out.limbs, n.limbs);
+            out.trim();
+        }
+    }
+
+    // base^exp，输入和输出均为 Montgomery 形式（滑动窗口，平方走 square）
+    BigInt powMontgomery(const BigInt& baseMont, const BigInt& exp) const {
+        return BigInt::windowedPow(baseMont, exp, rModN, [this](const BigInt& a, const BigInt& b, BigInt& out) {
+            if (&a == &b) square(a, out);
+            else multiply(a, b, out);
+        });
+    }
+
+    // base^exp mod n，输入和输出均为普通形式
+    BigInt pow(const BigInt& base, const BigInt& exp) const {
+        return fromMontgomery(powMontgomery(toMontgomery(base), exp));
+    }
+
+    // 不超过 64 位的短指数（如公钥指数 65537）：从左到右平方-乘，不建窗口表。
+    // 奇指数的最后一步乘以普通形式的底数，结果直接是普通形式，省去 fromMontgomery
+    BigInt pow(const BigInt& base, uint64_t exp) const {
+        if (exp == 0) return BigInt(1);
+        BigInt plain = base.negative || BigInt::compareAbs(base, n) >= 0 ? base % n : base;
+        if (plain.negative) plain += n;
+        if (exp == 1) return plain;
+
+        BigInt baseMont = multiply(plain, r2ModN);
+        BigInt result = baseMont;
+        BigInt tmp;
+        for (int bit = 62 - __builtin_clzll(exp); bit >= 1; --bit) {
+            square(result, tmp);
+            result.swap(tmp);
+            if ((exp >> bit) & 1) {
+                multiply(result, baseMont, tmp);
+                result.swap(tmp);
+            }
+        }
+        square(result, tmp);
+        multiply(tmp, (exp & 1) ? plain : BigInt(1), result);
+        return result;
+    }
+
+private:
+    BigInt n;       // 模数
+    size_t k;       // 模数的 limb 个数，R = 2^(64k)
+    Limb nPrime;    // -n^-1 mod 2^64
+    BigInt rModN;   // R mod n
+    BigInt r2ModN;  // R^2 mod n
+};
+
+// 线程的 Workspace 会与 Scope 内的对象交换缓冲区，回退前先让它放弃来自分配区的缓冲区
+inline LimbArena::Scope::~Scope() {
+    if (--arena.depth > 0) return;
+    BigInt::Workspace& ws = BigInt::threadWorkspace();
+    ws.num.dropArenaBuffer();
+    ws.den.dropArenaBuffer();
+    ws.prod.dropArenaBuffer();
+    ws.mul.dropArenaBuffer();
+    arena.chunkIndex = 0;
+    arena.offset = 0;
+}
+
+inline BigInt BigInt::modPow(const BigInt& base, const BigInt& exp, const BigInt& mod) {
+    if (mod.isOne()) return BigInt();
+    if (mod.isOdd() && !mod.negative) return MontgomeryContext(mod).pow(base, exp);
+    return modPowClassic(base, exp, mod);
+}
+
+inline BigInt BigInt::modPow(const BigInt& base, const BigInt& exp, const MontgomeryContext& ctx) {
+    return ctx.pow(base, exp);
+}
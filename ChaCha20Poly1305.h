@@ -0,0 +1,303 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// ChaCha20 流密码与 Poly1305 认证码（RFC 8439），供混合加密加密数据本体。
+// 只依赖标准库；多字节整数按小端读写。
+
+// ChaCha20 密钥流：32 字节密钥、12 字节 nonce、32 位块计数器
+class ChaCha20 {
+public:
+    ChaCha20(const unsigned char key[32], const unsigned char nonce[12], uint32_t counter = 0) {
+        state[0] = 0x61707865;
+        state[1] = 0x3320646e;
+        state[2] = 0x79622d32;
+        state[3] = 0x6b206574;
+        for (int i = 0; i < 8; ++i) state[4 + i] = load32(key + 4 * i);
+        state[12] = counter;
+        for (int i = 0; i < 3; ++i) state[13 + i] = load32(nonce + 4 * i);
+        keystreamPos = sizeof(keystream);
+    }
+
+    // out = in 异或密钥流，可分多次调用，密钥流位置跨调用连续。in 与 out 可以相同
+    void process(const unsigned char* in, unsigned char* out, size_t len) {
+        // 先用完上次剩下的密钥流
+        while (len > 0 && keystreamPos < sizeof(keystream)) {
+            *out++ = *in++ ^ keystream[keystreamPos++];
+            --len;
+        }
+        // 整批 4 块一起生成，直接与输入异或
+        while (len >= BATCH_BYTES) {
+            generate(keystream);
+            xorBytes(in, keystream, out, BATCH_BYTES);
+            in += BATCH_BYTES;
+            out += BATCH_BYTES;
+            len -= BATCH_BYTES;
+        }
+        if (len > 0) {
+            generate(keystream);
+            xorBytes(in, keystream, out, len);
+            keystreamPos = len;
+        }
+    }
+
+    // 取出下一段原始密钥流（Poly1305 一次性密钥即取计数器 0 的前 32 字节）
+    void keystreamBytes(unsigned char* out, size_t len) {
+        std::memset(out, 0, len);
+        process(out, out, len);
+    }
+
+private:
+    static constexpr size_t LANES = 4;
+    static constexpr size_t BATCH_BYTES = 64 * LANES;
+
+    uint32_t state[16];
+    unsigned char keystream[BATCH_BYTES];
+    size_t keystreamPos;
+
+    static uint32_t load32(const unsigned char* p) {
+        return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+
+    static void store32(unsigned char* p, uint32_t v) {
+        p[0] = (unsigned char)v;
+        p[1] = (unsigned char)(v >> 8);
+        p[2] = (unsigned char)(v >> 16);
+        p[3] = (unsigned char)(v >> 24);
+    }
+
+    static void xorBytes(const unsigned char* a, const unsigned char* b, unsigned char* out, size_t len) {
+        size_t i = 0;
+        for (; i + 8 <= len; i += 8) {
+            uint64_t x, y;
+            std::memcpy(&x, a + i, 8);
+            std::memcpy(&y, b + i, 8);
+            x ^= y;
+            std::memcpy(out + i, &x, 8);
+        }
+        for (; i < len; ++i) out[i] = a[i] ^ b[i];
+    }
+
+    // 4 个块并行：向量的第 l 个分量属于第 l 个块，每条向量指令同时推进 4 个块（SSE2 即可）
+    typedef uint32_t Lanes __attribute__((vector_size(16)));
+
+    static Lanes rotl(Lanes v, int c) {
+        return (v << c) | (v >> (32 - c));
+    }
+
+    static void quarterRound(Lanes& a, Lanes& b, Lanes& c, Lanes& d) {
+        a += b; d ^= a; d = rotl(d, 16);
+        c += d; b ^= c; b = rotl(b, 12);
+        a += b; d ^= a; d = rotl(d, 8);
+        c += d; b ^= c; b = rotl(b, 7);
+    }
+
+    // 生成计数器为 state[12] .. state[12]+3 的 4 个块，计数器前进 4
+    void generate(unsigned char* out) {
+        Lanes input[16];
+        for (int i = 0; i < 16; ++i) {
+            Lanes v = {state[i], state[i], state[i], state[i]};
+            input[i] = v;
+        }
+        Lanes offsets = {0, 1, 2, 3};
+        input[12] += offsets;
+
+        Lanes x[16];
+        for (int i = 0; i < 16; ++i) x[i] = input[i];
+        for (int round = 0; round < 10; ++round) {
+            quarterRound(x[0], x[4], x[8], x[12]);
+            quarterRound(x[1], x[5], x[9], x[13]);
+            quarterRound(x[2], x[6], x[10], x[14]);
+            quarterRound(x[3], x[7], x[11], x[15]);
+            quarterRound(x[0], x[5], x[10], x[15]);
+            quarterRound(x[1], x[6], x[11], x[12]);
+            quarterRound(x[2], x[7], x[8], x[13]);
+            quarterRound(x[3], x[4], x[9], x[14]);
+        }
+
+        for (int i = 0; i < 16; ++i) {
+            Lanes v = x[i] + input[i];
+            for (size_t l = 0; l < LANES; ++l) store32(out + 64 * l + 4 * i, v[l]);
+        }
+        state[12] += LANES;
+    }
+};
+
+// Poly1305 一次性认证码，内部用 3 个 44/44/42 位的分量表示累加值
+class Poly1305 {
+public:
+    explicit Poly1305(const unsigned char key[32]) {
+        uint64_t t0 = load64(key);
+        uint64_t t1 = load64(key + 8);
+        // r 按规范清除部分位
+        r[0] = t0 & 0xffc0fffffffULL;
+        r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffffULL;
+        r[2] = (t1 >> 24) & 0x00ffffffc0fULL;
+        h[0] = h[1] = h[2] = 0;
+        pad[0] = load64(key + 16);
+        pad[1] = load64(key + 24);
+        leftover = 0;
+    }
+
+    void update(const unsigned char* data, size_t len) {
+        if (len == 0) return;
+        if (leftover > 0) {
+            size_t take = len < 16 - leftover ? len : 16 - leftover;
+            std::memcpy(buffer + leftover, data, take);
+            leftover += take;
+            data += take;
+            len -= take;
+            if (leftover < 16) return;
+            blocks(buffer, 16, HIBIT);
+            leftover = 0;
+        }
+        size_t full = len & ~(size_t)15;
+        if (full > 0) blocks(data, full, HIBIT);
+        std::memcpy(buffer, data + full, len - full);
+        leftover = len - full;
+    }
+
+    // 用 0 补齐到 16 字节边界（AEAD 构造在附加数据和密文后各补一次）
+    void padToBlock() {
+        if (leftover == 0) return;
+        std::memset(buffer + leftover, 0, 16 - leftover);
+        blocks(buffer, 16, HIBIT);
+        leftover = 0;
+    }
+
+    void finish(unsigned char tag[16]) {
+        if (leftover > 0) {
+            buffer[leftover] = 1;
+            std::memset(buffer + leftover + 1, 0, 15 - leftover);
+            blocks(buffer, 16, 0);
+            leftover = 0;
+        }
+
+        // 完全进位，再计算 h - p，不小于 0 时取差
+        uint64_t h0 = h[0], h1 = h[1], h2 = h[2];
+        uint64_t c = h1 >> 44; h1 &= MASK44;
+        h2 += c; c = h2 >> 42; h2 &= MASK42;
+        h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+        h1 += c; c = h1 >> 44; h1 &= MASK44;
+        h2 += c; c = h2 >> 42; h2 &= MASK42;
+        h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+        h1 += c;
+
+        uint64_t g0 = h0 + 5; c = g0 >> 44; g0 &= MASK44;
+        uint64_t g1 = h1 + c; c = g1 >> 44; g1 &= MASK44;
+        uint64_t g2 = h2 + c - ((uint64_t)1 << 42);
+        uint64_t mask = (g2 >> 63) - 1; // g2 未借位（h >= p）时为全 1
+        h0 = (h0 & ~mask) | (g0 & mask);
+        h1 = (h1 & ~mask) | (g1 & mask);
+        h2 = (h2 & ~mask) | (g2 & mask);
+
+        // tag = (h + s) mod 2^128
+        uint64_t t0 = pad[0], t1 = pad[1];
+        h0 += t0 & MASK44; c = h0 >> 44; h0 &= MASK44;
+        h1 += (((t0 >> 44) | (t1 << 20)) & MASK44) + c; c = h1 >> 44; h1 &= MASK44;
+        h2 += ((t1 >> 24) & MASK42) + c; h2 &= MASK42;
+        store64(tag, h0 | (h1 << 44));
+        store64(tag + 8, (h1 >> 20) | (h2 << 24));
+    }
+
+private:
+    static constexpr uint64_t MASK44 = 0xfffffffffffULL;
+    static constexpr uint64_t MASK42 = 0x3ffffffffffULL;
+    static constexpr uint64_t HIBIT = (uint64_t)1 << 40; // 每个完整块末尾追加的 1（2^128 在 h2 中的位置）
+
+    uint64_t r[3], h[3], pad[2];
+    unsigned char buffer[16];
+    size_t leftover;
+
+    static uint64_t load64(const unsigned char* p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+        return v;
+    }
+
+    static void store64(unsigned char* p, uint64_t v) {
+        for (int i = 0; i < 8; ++i) p[i] = (unsigned char)(v >> (8 * i));
+    }
+
+    // 依次处理 16 字节块：h = (h + m) * r mod 2^130 - 5
+    void blocks(const unsigned char* m, size_t bytes, uint64_t hibit) {
+        const uint64_t r0 = r[0], r1 = r[1], r2 = r[2];
+        const uint64_t s1 = r1 * (5 << 2), s2 = r2 * (5 << 2);
+        uint64_t h0 = h[0], h1 = h[1], h2 = h[2];
+        for (; bytes >= 16; bytes -= 16, m += 16) {
+            uint64_t t0 = load64(m), t1 = load64(m + 8);
+            h0 += t0 & MASK44;
+            h1 += ((t0 >> 44) | (t1 << 20)) & MASK44;
+            h2 += ((t1 >> 24) & MASK42) | hibit;
+
+            unsigned __int128 d0 = (unsigned __int128)h0 * r0 + (unsigned __int128)h1 * s2 + (unsigned __int128)h2 * s1;
+            unsigned __int128 d1 = (unsigned __int128)h0 * r1 + (unsigned __int128)h1 * r0 + (unsigned __int128)h2 * s2;
+            unsigned __int128 d2 = (unsigned __int128)h0 * r2 + (unsigned __int128)h1 * r1 + (unsigned __int128)h2 * r0;
+
+            uint64_t c = (uint64_t)(d0 >> 44); h0 = (uint64_t)d0 & MASK44;
+            d1 += c; c = (uint64_t)(d1 >> 44); h1 = (uint64_t)d1 & MASK44;
+            d2 += c; c = (uint64_t)(d2 >> 42); h2 = (uint64_t)d2 & MASK42;
+            h0 += c * 5; c = h0 >> 44; h0 &= MASK44;
+            h1 += c;
+        }
+        h[0] = h0;
+        h[1] = h1;
+        h[2] = h2;
+    }
+};
+
+// ChaCha20-Poly1305 AEAD（RFC 8439 第 2.8 节）：每条消息一个 nonce，同一密钥下 nonce 不得重复
+class ChaCha20Poly1305 {
+public:
+    static constexpr size_t KEY_SIZE = 32;
+    static constexpr size_t NONCE_SIZE = 12;
+    static constexpr size_t TAG_SIZE = 16;
+
+    // 加密 len 字节并输出认证标签；in 与 out 可以相同
+    static void seal(const unsigned char key[KEY_SIZE], const unsigned char nonce[NONCE_SIZE],
+                     const unsigned char* aad, size_t aadLen,
+                     const unsigned char* in, size_t len, unsigned char* out, unsigned char tag[TAG_SIZE]) {
+        ChaCha20 cipher(key, nonce, 0);
+        unsigned char polyKey[64];
+        cipher.keystreamBytes(polyKey, sizeof(polyKey)); // 块 0 作 Poly1305 密钥，数据从块 1 开始
+        cipher.process(in, out, len);
+        computeTag(polyKey, aad, aadLen, out, len, tag);
+    }
+
+    // 先校验标签再解密；标签不符时返回 false，且不写出任何明文
+    static bool open(const unsigned char key[KEY_SIZE], const unsigned char nonce[NONCE_SIZE],
+                     const unsigned char* aad, size_t aadLen,
+                     const unsigned char* in, size_t len, const unsigned char tag[TAG_SIZE], unsigned char* out) {
+        ChaCha20 cipher(key, nonce, 0);
+        unsigned char polyKey[64];
+        cipher.keystreamBytes(polyKey, sizeof(polyKey));
+        unsigned char expected[TAG_SIZE];
+        computeTag(polyKey, aad, aadLen, in, len, expected);
+
+        // 常数时间比较
+        unsigned char diff = 0;
+        for (size_t i = 0; i < TAG_SIZE; ++i) diff |= expected[i] ^ tag[i];
+        if (diff != 0) return false;
+
+        cipher.process(in, out, len);
+        return true;
+    }
+
+private:
+    static void computeTag(const unsigned char polyKey[32], const unsigned char* aad, size_t aadLen,
+                           const unsigned char* cipher, size_t len, unsigned char tag[TAG_SIZE]) {
+        Poly1305 mac(polyKey);
+        mac.update(aad, aadLen);
+        mac.padToBlock();
+        mac.update(cipher, len);
+        mac.padToBlock();
+        unsigned char lengths[16];
+        for (int i = 0; i < 8; ++i) {
+            lengths[i] = (unsigned char)((uint64_t)aadLen >> (8 * i));
+            lengths[8 + i] = (unsigned char)((uint64_t)len >> (8 * i));
+        }
+        mac.update(lengths, sizeof(lengths));
+        mac.finish(tag);
+    }
+};
@@ -1,11 +1,105 @@
 #pragma once
 #include "BigInt.h"
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <iterator>
 #include <sstream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define KEYMANAGER_HAS_MMAP 1
+#else
+#define KEYMANAGER_HAS_MMAP 0
+#endif
 
 class KeyManager {
 public:
-    // 湫Կļ
+    // 密钥文件格式
+    enum class Format {
+        Text,   // 每行一个十进制数
+        Binary  // 带版本号和校验和的小端 limb 数组，见 saveBinaryKey
+    };
+
+    // 多素数 RSA（RFC 8017）中第 3 个及以后的素因子 r_i，及其 CRT 指数 d mod (r_i - 1)
+    // 和系数 t_i = (r_1 * ... * r_(i-1))^-1 mod r_i，其中 r_1 = p, r_2 = q
+    struct PrimeInfo {
+        BigInt r, d, t;
+    };
+
+    // 二进制密钥文件中的全部字段，未使用的字段为 0；两素数密钥的 otherPrimes 为空
+    struct KeyData {
+        BigInt e, d, n;
+        BigInt p, q, dP, dQ, qInv;
+        std::vector<PrimeInfo> otherPrimes;
+    };
+
+    // 保存二进制密钥文件。布局（多字节整数均为小端）：
+    //   0   魔数 "RSAK"
+    //   4   u16 版本号：1 为两素数密钥；2 为多素数密钥，字段之后追加 otherPrimes
+    //   6   u16 标志：bit0 含 e，bit1 含 d，bit2 含 CRT 参数，bit3 含多素数参数
+    //   8   u32 字段个数（版本 1 为 8，版本 2 为 8 + 3 * 额外素因子个数）
+    //   12  u32 保留
+    //   16  依次为 e, d, n, p, q, dP, dQ, qInv，版本 2 再接每个额外素因子的 r, d, t：
+    //       u32 limb 个数、u32 保留、limb 个数 * 8 字节
+    //   末尾 u64 之前全部字节的 FNV-1a 校验和
+    // 每个 limb 数组都从 8 字节对齐的偏移开始。两素数密钥仍写成版本 1，旧程序可以读取。
+    static bool saveBinaryKey(const KeyData& key, const std::string& filename) {
+        std::vector<const BigInt*> fields = {&key.e, &key.d, &key.n, &key.p,
+                                             &key.q, &key.dP, &key.dQ, &key.qInv};
+        for (const PrimeInfo& info : key.otherPrimes) {
+            fields.insert(fields.end(), {&info.r, &info.d, &info.t});
+        }
+        uint16_t flags = 0;
+        if (!key.e.isZero()) flags |= FLAG_PUBLIC;
+        if (!key.d.isZero()) flags |= FLAG_PRIVATE;
+        if (!key.p.isZero() && !key.q.isZero()) flags |= FLAG_CRT;
+        if (!key.otherPrimes.empty()) flags |= FLAG_MULTI_PRIME;
+
+        size_t size = BINARY_HEADER_SIZE + 8;
+        for (const BigInt* f : fields) size += 8 + f->limbCount() * 8;
+
+        std::vector<unsigned char> buf(size, 0);
+        std::memcpy(buf.data(), BINARY_MAGIC, 4);
+        putLE(&buf[4], key.otherPrimes.empty() ? BINARY_VERSION : BINARY_VERSION_MULTI_PRIME, 2);
+        putLE(&buf[6], flags, 2);
+        putLE(&buf[8], fields.size(), 4);
+        size_t pos = BINARY_HEADER_SIZE;
+        for (const BigInt* f : fields) {
+            putLE(&buf[pos], f->limbCount(), 4);
+            pos += 8;
+            f->toLittleEndianLimbs(&buf[pos]);
+            pos += f->limbCount() * 8;
+        }
+        putLE(&buf[pos], fnv1a(buf.data(), pos), 8);
+
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(buf.data()), (std::streamsize)buf.size());
+        return file.good();
+    }
+
+    // 加载二进制密钥文件（通过 mmap 映射，limb 直接从映射区复制）。
+    // 魔数、版本、长度或校验和不符时返回 false
+    static bool loadBinaryKey(KeyData& key, const std::string& filename) {
+        MappedFile file(filename);
+        return file.ok() && isBinaryKey(file) && parseBinaryKey(file, key);
+    }
+
+    // 文件是否以二进制密钥魔数开头
+    static bool isBinaryKeyFile(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        char magic[4];
+        return file.read(magic, 4) && std::memcmp(magic, BINARY_MAGIC, 4) == 0;
+    }
+
+    // 保存公钥到文件
     static bool savePublicKey(const BigInt& e, const BigInt& n, const std::string& filename = "public_key.txt") {
         std::ofstream file(filename);
         if (!file.is_open()) {
@@ -17,7 +111,7 @@ public:
         return true;
     }
 
-    // ˽Կļ
+    // 保存私钥到文件
     static bool savePrivateKey(const BigInt& d, const BigInt& n, const std::string& filename = "private_key.txt") {
         std::ofstream file(filename);
         if (!file.is_open()) {
@@ -29,51 +123,305 @@ public:
         return true;
     }
 
-    // عԿ
-    static bool loadPublicKey(BigInt& e, BigInt& n, const std::string& filename = "public_key.txt") {
-        std::ifstream file(filename);
+    // 保存带 CRT 参数的私钥：前两行与旧格式相同，之后依次为 p, q, dP, dQ, qInv
+    static bool savePrivateKey(const BigInt& d, const BigInt& n,
+                               const BigInt& p, const BigInt& q,
+                               const BigInt& dP, const BigInt& dQ, const BigInt& qInv,
+                               const std::string& filename = "private_key.txt") {
+        std::ofstream file(filename);
         if (!file.is_open()) {
             return false;
         }
-        std::string e_str, n_str;
-        std::getline(file, e_str);
-        std::getline(file, n_str);
+        file << d.toString() << std::endl;
+        file << n.toString() << std::endl;
+        file << p.toString() << std::endl;
+        file << q.toString() << std::endl;
+        file << dP.toString() << std::endl;
+        file << dQ.toString() << std::endl;
+        file << qInv.toString() << std::endl;
         file.close();
+        return true;
+    }
+
+    // 保存 key 中的私钥部分（d、n 及 CRT 参数）。多素数密钥在七行之后每个额外素因子再占三行：r, d, t；
+    // 只认识七行格式的旧程序加载这种文件时，p * q 与 n 不符，会退回到不用 CRT 的 d 运算
+    static bool savePrivateKey(const KeyData& key, const std::string& filename = "private_key.txt") {
+        if (key.p.isZero() || key.q.isZero()) return savePrivateKey(key.d, key.n, filename);
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            return false;
+        }
+        for (const BigInt* f : {&key.d, &key.n, &key.p, &key.q, &key.dP, &key.dQ, &key.qInv}) {
+            file << f->toString() << std::endl;
+        }
+        for (const PrimeInfo& info : key.otherPrimes) {
+            file << info.r.toString() << std::endl;
+            file << info.d.toString() << std::endl;
+            file << info.t.toString() << std::endl;
+        }
+        file.close();
+        return true;
+    }
 
-        if (e_str.empty() || n_str.empty()) {
+    // 加载公钥（文本或二进制格式，按文件开头的魔数自动识别）
+    static bool loadPublicKey(BigInt& e, BigInt& n, const std::string& filename = "public_key.txt") {
+        MappedFile file(filename);
+        if (!file.ok()) {
+            return false;
+        }
+        if (isBinaryKey(file)) {
+            KeyData key;
+            if (!parseBinaryKey(file, key) || key.e.isZero() || key.n.isZero()) {
+                return false;
+            }
+            e = std::move(key.e);
+            n = std::move(key.n);
+            return true;
+        }
+
+        std::string lines[2];
+        readLines(file, lines, 2);
+        if (lines[0].empty() || lines[1].empty()) {
             return false;
         }
 
-        e = BigInt(e_str);
-        n = BigInt(n_str);
+        e = BigInt(lines[0]);
+        n = BigInt(lines[1]);
         return true;
     }
 
-    // ˽Կ
+    // 加载私钥（文本或二进制格式）
     static bool loadPrivateKey(BigInt& d, BigInt& n, const std::string& filename = "private_key.txt") {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
+        BigInt p, q, dP, dQ, qInv;
+        return loadPrivateKey(d, n, p, q, dP, dQ, qInv, filename);
+    }
+
+    // 加载私钥及 CRT 参数（两素数密钥）。多素数密钥文件只取前两个素因子，
+    // 此时 p * q 与 n 不符，需要多素数参数时请用 loadPrivateKey(KeyData&, ...)
+    static bool loadPrivateKey(BigInt& d, BigInt& n,
+                               BigInt& p, BigInt& q,
+                               BigInt& dP, BigInt& dQ, BigInt& qInv,
+                               const std::string& filename = "private_key.txt") {
+        KeyData key;
+        if (!loadPrivateKey(key, filename)) {
             return false;
         }
-        std::string d_str, n_str;
-        std::getline(file, d_str);
-        std::getline(file, n_str);
-        file.close();
+        d = std::move(key.d);
+        n = std::move(key.n);
+        p = std::move(key.p);
+        q = std::move(key.q);
+        dP = std::move(key.dP);
+        dQ = std::move(key.dQ);
+        qInv = std::move(key.qInv);
+        return true;
+    }
 
-        if (d_str.empty() || n_str.empty()) {
+    // 加载私钥到 key 的 d、n、CRT 参数和 otherPrimes（e 保持不变）；
+    // 旧的两行格式同样可以加载，此时 CRT 参数均置为 0
+    static bool loadPrivateKey(KeyData& key, const std::string& filename = "private_key.txt") {
+        MappedFile file(filename);
+        if (!file.ok()) {
             return false;
         }
+        if (isBinaryKey(file)) {
+            KeyData loaded;
+            if (!parseBinaryKey(file, loaded) || loaded.d.isZero() || loaded.n.isZero()) {
+                return false;
+            }
+            loaded.e = std::move(key.e);
+            key = std::move(loaded);
+            return true;
+        }
+
+        std::vector<std::string> lines;
+        readLines(file, lines);
+        if (lines.size() < 2 || lines[0].empty() || lines[1].empty()) {
+            return false;
+        }
+
+        key.d = BigInt(lines[0]);
+        key.n = BigInt(lines[1]);
+        key.otherPrimes.clear();
 
-        d = BigInt(d_str);
-        n = BigInt(n_str);
+        bool hasCrt = lines.size() >= 7;
+        for (size_t i = 2; i < 7 && hasCrt; ++i) {
+            if (lines[i].empty()) hasCrt = false;
+        }
+        if (hasCrt) {
+            key.p = BigInt(lines[2]);
+            key.q = BigInt(lines[3]);
+            key.dP = BigInt(lines[4]);
+            key.dQ = BigInt(lines[5]);
+            key.qInv = BigInt(lines[6]);
+            // 之后每三行为一个额外素因子；行数不完整的文件视为损坏
+            size_t extra = lines.size() - 7;
+            if (extra % 3 != 0) return false;
+            for (size_t i = 7; i < lines.size(); i += 3) {
+                if (lines[i].empty() || lines[i + 1].empty() || lines[i + 2].empty()) return false;
+                key.otherPrimes.push_back({BigInt(lines[i]), BigInt(lines[i + 1]), BigInt(lines[i + 2])});
+            }
+        } else {
+            key.p = key.q = key.dP = key.dQ = key.qInv = BigInt();
+        }
         return true;
     }
 
-    // ԿļǷ
+    // 检查密钥文件是否存在
     static bool keysExist(const std::string& publicKeyFile = "public_key.txt", 
                          const std::string& privateKeyFile = "private_key.txt") {
         std::ifstream pubFile(publicKeyFile);
         std::ifstream privFile(privateKeyFile);
         return pubFile.good() && privFile.good();
     }
+
+private:
+    static constexpr char BINARY_MAGIC[4] = {'R', 'S', 'A', 'K'};
+    static constexpr uint16_t BINARY_VERSION = 1;
+    static constexpr uint16_t BINARY_VERSION_MULTI_PRIME = 2;
+    static constexpr uint32_t BINARY_FIELD_COUNT = 8;  // 版本 1 的字段个数，也是版本 2 的固定部分
+    static constexpr size_t BINARY_HEADER_SIZE = 16;
+    static constexpr uint16_t FLAG_PUBLIC = 1;
+    static constexpr uint16_t FLAG_PRIVATE = 2;
+    static constexpr uint16_t FLAG_CRT = 4;
+    static constexpr uint16_t FLAG_MULTI_PRIME = 8;
+
+    static void putLE(unsigned char* out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) out[i] = (unsigned char)(value >> (8 * i));
+    }
+
+    static uint64_t getLE(const unsigned char* in, int bytes) {
+        uint64_t value = 0;
+        for (int i = bytes - 1; i >= 0; --i) value = (value << 8) | in[i];
+        return value;
+    }
+
+    static uint64_t fnv1a(const unsigned char* data, size_t len) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < len; ++i) {
+            hash ^= data[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // 只读映射整个文件。不支持 mmap 的平台，以及管道、/dev/stdin、procfs 等
+    // 非普通文件或报告长度为 0 的文件，退回到一次性读入内存
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& filename) {
+#if KEYMANAGER_HAS_MMAP
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            struct stat st;
+            if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+                void* p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    mapped = static_cast<const unsigned char*>(p);
+                    len = (size_t)st.st_size;
+                }
+            }
+            ::close(fd);
+            if (mapped) return;
+#endif
+            std::ifstream file(filename, std::ios::binary);
+            if (!file.is_open()) return;
+            buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            len = buffer.size();
+        }
+
+        ~MappedFile() {
+#if KEYMANAGER_HAS_MMAP
+            if (mapped) ::munmap(const_cast<unsigned char*>(mapped), len);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool ok() const { return len > 0; }
+        size_t size() const { return len; }
+
+        const unsigned char* data() const {
+            if (mapped) return mapped;
+            return reinterpret_cast<const unsigned char*>(buffer.data());
+        }
+
+    private:
+        size_t len = 0;
+        const unsigned char* mapped = nullptr; // 映射成功时指向映射区，否则内容在 buffer 中
+        std::vector<char> buffer;
+    };
+
+    static bool isBinaryKey(const MappedFile& file) {
+        return file.size() >= 4 && std::memcmp(file.data(), BINARY_MAGIC, 4) == 0;
+    }
+
+    // 校验并解析二进制密钥文件的内容，格式见 saveBinaryKey
+    static bool parseBinaryKey(const MappedFile& file, KeyData& key) {
+        const unsigned char* data = file.data();
+        size_t size = file.size();
+        if (size < BINARY_HEADER_SIZE + 8 || std::memcmp(data, BINARY_MAGIC, 4) != 0) {
+            return false;
+        }
+        uint64_t version = getLE(data + 4, 2);
+        uint64_t count = getLE(data + 8, 4);
+        bool validCount = version == BINARY_VERSION ? count == BINARY_FIELD_COUNT
+                        : version == BINARY_VERSION_MULTI_PRIME &&
+                          count > BINARY_FIELD_COUNT && (count - BINARY_FIELD_COUNT) % 3 == 0;
+        if (!validCount) {
+            return false;
+        }
+        if (getLE(data + size - 8, 8) != fnv1a(data, size - 8)) {
+            return false;
+        }
+
+        // 每个字段至少占 8 字节，字段个数不可能超过文件长度允许的范围
+        if (count > size / 8) {
+            return false;
+        }
+        key.otherPrimes.assign((size_t)(count - BINARY_FIELD_COUNT) / 3, PrimeInfo());
+        std::vector<BigInt*> fields = {&key.e, &key.d, &key.n, &key.p,
+                                       &key.q, &key.dP, &key.dQ, &key.qInv};
+        for (PrimeInfo& info : key.otherPrimes) {
+            fields.insert(fields.end(), {&info.r, &info.d, &info.t});
+        }
+        size_t pos = BINARY_HEADER_SIZE;
+        size_t end = size - 8;
+        for (BigInt* f : fields) {
+            if (end - pos < 8) {
+                return false;
+            }
+            uint64_t count = getLE(data + pos, 4);
+            pos += 8;
+            if (count > (end - pos) / 8) {
+                return false;
+            }
+            *f = BigInt::fromLittleEndianLimbs(data + pos, (size_t)count);
+            pos += (size_t)count * 8;
+        }
+        return pos == end;
+    }
+
+    // 按 '\n' 切分文本密钥文件，最多取 maxLines 行
+    static void readLines(const MappedFile& file, std::string* lines, size_t maxLines) {
+        const char* p = reinterpret_cast<const char*>(file.data());
+        const char* end = p + file.size();
+        for (size_t i = 0; i < maxLines && p < end; ++i) {
+            const char* nl = std::find(p, end, '\n');
+            lines[i].assign(p, nl);
+            p = nl < end ? nl + 1 : end;
+        }
+    }
+
+    // 读取全部行，末尾的空行不计入
+    static void readLines(const MappedFile& file, std::vector<std::string>& lines) {
+        const char* p = reinterpret_cast<const char*>(file.data());
+        const char* end = p + file.size();
+        while (p < end) {
+            const char* nl = std::find(p, end, '\n');
+            lines.emplace_back(p, nl);
+            p = nl < end ? nl + 1 : end;
+        }
+        while (!lines.empty() && lines.back().empty()) lines.pop_back();
+    }
 };
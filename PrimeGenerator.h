@@ -1,42 +1,79 @@
 #pragma once
 #include "BigInt.h"
+#include "SystemRandom.h"
 #include <random>
 #include <ctime>
 #include <vector>
 #include <chrono>
+#include <array>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+
+// 编译期用试除法生成前 N 个素数
+template <size_t N>
+constexpr std::array<uint32_t, N> makeSmallPrimeTable() {
+    std::array<uint32_t, N> primes{};
+    size_t count = 0;
+    for (uint32_t c = 2; count < N; ++c) {
+        bool prime = true;
+        for (size_t i = 0; i < count && primes[i] * primes[i] <= c; ++i) {
+            if (c % primes[i] == 0) {
+                prime = false;
+                break;
+            }
+        }
+        if (prime) primes[count++] = c;
+    }
+    return primes;
+}
 
 class PrimeGenerator {
 public:
-    // ݰȫȼ
+    // 候选数预筛用的小素数表（前 2048 个素数，最大为 17863）
+    static constexpr size_t SMALL_PRIME_COUNT = 2048;
+    static constexpr std::array<uint32_t, SMALL_PRIME_COUNT> SMALL_PRIMES = makeSmallPrimeTable<SMALL_PRIME_COUNT>();
+
+    // 每个筛窗口包含的奇数候选个数
+    static constexpr size_t SIEVE_WINDOW = 4096;
+
+    // isProbablePrime 直接试除的小素数个数（筛窗口出来的候选数不再重复试除）
+    static constexpr size_t TRIAL_DIVISION_PRIMES = 64;
+
+    // 根据安全等级生成随机素数对
     static std::pair<BigInt, BigInt> getSafePrimePair(int level = 1) {
+        // 级别 5 及以上按模数位数生成
+        size_t modulusBits = modulusBitsForLevel(level);
+        if (modulusBits > 0) return getPrimePairBits(modulusBits);
+
         long long min_p, max_p, min_q, max_q;
         
         switch (level) {
-            case 0: // ʾС
+            case 0: // 演示级（小素数）
                 min_p = 50;
                 max_p = 100;
                 min_q = 50;
                 max_q = 100;
                 break;
-            case 1: // ͼԼ1000ң
+            case 1: // 低级（约1000左右）
                 min_p = 900;
                 max_p = 1100;
                 min_q = 900;
                 max_q = 1100;
                 break;
-            case 2: // мԼ10000ң
+            case 2: // 中级（约10000左右）
                 min_p = 9000;
                 max_p = 11000;
                 min_q = 9000;
                 max_q = 11000;
                 break;
-            case 3: // ߼Լ100000ң
+            case 3: // 高级（约100000左右）
                 min_p = 90000;
                 max_p = 110000;
                 min_q = 90000;
                 max_q = 110000;
                 break;
-            case 4: // ߼Լ1000000ң
+            case 4: // 极高级（约1000000左右）
                 min_p = 900000;
                 max_p = 1100000;
                 min_q = 900000;
@@ -53,7 +90,7 @@ public:
         BigInt p = generatePrime(min_p, max_p);
         BigInt q = generatePrime(min_q, max_q);
         
-        // ȷ p  q 
+        // 确保 p 和 q 不相等
         while (p == q) {
             q = generatePrime(min_q, max_q);
         }
@@ -61,50 +98,229 @@ public:
         return {p, q};
     }
 
-    // -Բ
-    static bool isProbablePrime(const BigInt& n, int iterations = 10) {
-        if (n == BigInt(2) || n == BigInt(3)) return true;
-        if (n < BigInt(2) || n.toString().back() % 2 == 0) return false;
+    // 各级别对应的模数位数，0 表示按数值范围生成的旧级别
+    static size_t modulusBitsForLevel(int level) {
+        switch (level) {
+            case 5: return 512;
+            case 6: return 1024;
+            case 7: return 2048;
+            case 8: return 3072;
+            case 9: return 4096;
+            default: return 0;
+        }
+    }
+
+    // 生成模数恰为 modulusBits 位的素数对。素数候选取自系统熵源（SystemRandom）
+    static std::pair<BigInt, BigInt> getPrimePairBits(size_t modulusBits) {
+        size_t pBits = modulusBits / 2;
+        size_t qBits = modulusBits - pBits;
+
+        SystemRandom gen;
+        BigInt p = generatePrimeBits(pBits, gen);
+        BigInt q = generatePrimeBits(qBits, gen);
 
-        //  n-1 д 2^r * d ʽ
-        BigInt d = n - BigInt(1);
-        int r = 0;
-        while (d.toString().back() % 2 == 0) {
-            d = d / BigInt(2);
-            r++;
+        // 确保 p 和 q 不相等
+        while (p == q) {
+            q = generatePrimeBits(qBits, gen);
         }
 
-        // жֲ
-        std::random_device rd;
-        auto seed = rd() ^ static_cast<unsigned>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
-        std::mt19937_64 gen(seed);
-        
-        for (int i = 0; i < iterations; i++) {
-            //  a  [2, n-2]
-            BigInt a = getRandomBigInt(2, n - BigInt(2), gen);
-            BigInt x = BigInt::modPow(a, d, n);
+        return {p, q};
+    }
 
-            if (x == BigInt(1) || x == n - BigInt(1))
-                continue;
+    // 生成 count 个互不相同的素数（多素数 RSA），位数尽量均衡，乘积恰为 modulusBits 位。
+    // 每个素数最高两位为 1，但三个以上相乘仍可能少一位，此时轮流重新生成其中一个素数
+    static std::vector<BigInt> getPrimesBits(size_t modulusBits, size_t count) {
+        std::vector<size_t> bits = balancedPrimeBits(modulusBits, count);
+        SystemRandom gen;
+        std::vector<BigInt> primes;
+        for (size_t i = 0; i < count; ++i) {
+            primes.push_back(generatePrimeBits(bits[i], gen));
+        }
+        for (size_t attempt = 0, i; (i = unusablePrime(primes, modulusBits, attempt)) < count; ++attempt) {
+            primes[i] = generatePrimeBits(bits[i], gen);
+        }
+        return primes;
+    }
+
+    // 多线程生成多个素数：各素数同时搜索，每个素数各用 threads / count 个线程
+    static std::vector<BigInt> getPrimesBitsParallel(size_t modulusBits, size_t count, size_t threads = 0) {
+        std::vector<size_t> bits = balancedPrimeBits(modulusBits, count);
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t perPrime = std::max<size_t>(1, threads / count);
+
+        std::vector<BigInt> primes(count);
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < count; ++i) {
+            workers.emplace_back([&, i] { primes[i] = generatePrimeBitsParallel(bits[i], perPrime); });
+        }
+        primes[0] = generatePrimeBitsParallel(bits[0], perPrime);
+        for (std::thread& t : workers) t.join();
+
+        for (size_t attempt = 0, i; (i = unusablePrime(primes, modulusBits, attempt)) < count; ++attempt) {
+            primes[i] = generatePrimeBitsParallel(bits[i], threads);
+        }
+        return primes;
+    }
+
+    // 多线程生成素数对：p 和 q 同时搜索，每个素数各用 threads / 2 个线程。
+    // threads 为 0 时使用硬件并发数；级别 0-4 的素数很小，直接顺序生成。
+    static std::pair<BigInt, BigInt> getSafePrimePairParallel(int level = 1, size_t threads = 0) {
+        size_t modulusBits = modulusBitsForLevel(level);
+        if (modulusBits == 0) return getSafePrimePair(level);
+        return getPrimePairBitsParallel(modulusBits, threads);
+    }
+
+    static std::pair<BigInt, BigInt> getPrimePairBitsParallel(size_t modulusBits, size_t threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t perPrime = std::max<size_t>(1, threads / 2);
+        size_t pBits = modulusBits / 2;
+        size_t qBits = modulusBits - pBits;
+
+        BigInt p, q;
+        std::thread pThread([&] { p = generatePrimeBitsParallel(pBits, perPrime); });
+        q = generatePrimeBitsParallel(qBits, perPrime);
+        pThread.join();
+
+        // 确保 p 和 q 不相等
+        while (p == q) {
+            q = generatePrimeBitsParallel(qBits, perPrime);
+        }
+
+        return {p, q};
+    }
+
+    // 多线程生成 bits 位素数。所有线程共享一个随机起点，线程 w 依次检查第 w, w+T, w+2T, ... 个筛窗口，
+    // 因此各线程测试的候选数互不重叠。第一个找到素数的线程置位 found，其余线程在下一个候选数前退出。
+    // 起点和各线程重新选取的起点都直接取自系统熵源，每个线程各用一个 SystemRandom
+    static BigInt generatePrimeBitsParallel(size_t bits, size_t threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        if (threads == 1 || bits < 32) return generatePrimeBits(bits);
+
+        SystemRandom gen;
+        BigInt base = randomPrimeStart(bits, gen);
+
+        std::atomic<bool> found(false);
+        BigInt result;
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < threads; ++w) {
+            workers.emplace_back([&, w] {
+                SystemRandom workerGen;
+                BigInt start = base;
+                size_t window = w;
+                while (!found.load(std::memory_order_relaxed)) {
+                    BigInt windowStart = start + BigInt((long long)(2 * SIEVE_WINDOW * window));
+                    window += threads;
+                    if (windowStart.bitLength() > bits) {
+                        // 超出位数范围（概率极小）：换一个新的随机起点
+                        start = randomPrimeStart(bits, workerGen);
+                        window = 0;
+                        continue;
+                    }
+
+                    std::vector<bool> composite = sieveWindow(windowStart, SIEVE_WINDOW);
+                    for (size_t j = 0; j < SIEVE_WINDOW; ++j) {
+                        if (found.load(std::memory_order_relaxed)) return;
+                        if (composite[j]) continue;
+                        BigInt candidate = windowStart + BigInt(2 * (long long)j);
+                        if (candidate.bitLength() > bits) break;
+                        if (probablePrimeAfterSieve(candidate)) {
+                            bool expected = false;
+                            if (found.compare_exchange_strong(expected, true)) result = candidate;
+                            return;
+                        }
+                    }
+                }
+            });
+        }
+        for (std::thread& t : workers) t.join();
+        return result;
+    }
+
+    // 生成恰为 bits 位的随机素数。最高两位都置 1，
+    // 这样两个 k 位素数之积恰为 2k 位。
+    static BigInt generatePrimeBits(size_t bits) {
+        SystemRandom gen;
+        return generatePrimeBits(bits, gen);
+    }
+
+    // gen 决定候选数的起点；生成密钥时应使用 SystemRandom，可复现的生成器只适合测试
+    template <typename URBG>
+    static BigInt generatePrimeBits(size_t bits, URBG& gen) {
+        if (bits < 3) throw std::invalid_argument("prime bit length must be at least 3");
+        if (bits < 32) {
+            return generatePrime(3LL << (bits - 2), (1LL << bits) - 1);
+        }
+
+        while (true) {
+            BigInt start = randomPrimeStart(bits, gen);
+
+            std::vector<bool> composite = sieveWindow(start, SIEVE_WINDOW);
+            for (size_t j = 0; j < SIEVE_WINDOW; ++j) {
+                if (composite[j]) continue;
+                BigInt candidate = start + BigInt(2 * (long long)j);
+                if (candidate.bitLength() > bits) break;
+                if (probablePrimeAfterSieve(candidate)) {
+                    return candidate;
+                }
+            }
+        }
+    }
+
+    // 素性测试，分两级：
+    //   n < 2^64：原生 64 位 Montgomery 运算 + 确定性米勒-拉宾（前 12 个素数为基，结果确定）
+    //   n >= 2^64：试除小素数后做 Baillie-PSW（以 2 为基的强伪素数测试 + 强 Lucas 测试）；
+    //              iterations > 0 时改为 iterations 轮随机基米勒-拉宾
+    static bool isProbablePrime(const BigInt& n, int iterations = 0) {
+        if (n < 2) return false;
+        if (n.bitLength() <= 64) return isPrime64(n.toUint64());
+        if (!n.isOdd()) return false;
+
+        for (size_t i = 1; i < TRIAL_DIVISION_PRIMES; ++i) {
+            if (n.modSmall(SMALL_PRIMES[i]) == 0) return false;
+        }
+        return probablePrimeAfterSieve(n, iterations);
+    }
+
+    // 64 位确定性素性测试
+    static bool isPrime64(uint64_t n) {
+        if (n < 2) return false;
+        for (size_t i = 0; i < TRIAL_DIVISION_PRIMES; ++i) {
+            uint64_t p = SMALL_PRIMES[i];
+            if (n == p) return true;
+            if (n % p == 0) return false;
+        }
+        // 已试除到 SMALL_PRIMES[TRIAL_DIVISION_PRIMES - 1]，更小的数必为素数
+        uint64_t lastTried = SMALL_PRIMES[TRIAL_DIVISION_PRIMES - 1];
+        if (n < lastTried * lastTried) return true;
+
+        Montgomery64 ctx(n);
+        uint64_t d = n - 1;
+        int r = __builtin_ctzll(d);
+        d >>= r;
+
+        uint64_t one = ctx.one();
+        uint64_t minusOne = n - one; // -1 的 Montgomery 形式
+        static const uint64_t witnesses[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+        for (uint64_t a : witnesses) {
+            uint64_t x = ctx.pow(ctx.toMontgomery(a), d);
+            if (x == one || x == minusOne) continue;
 
             bool composite = true;
             for (int j = 0; j < r - 1; j++) {
-                x = BigInt::modPow(x, BigInt(2), n);
-                if (x == n - BigInt(1)) {
+                x = ctx.multiply(x, x);
+                if (x == minusOne) {
                     composite = false;
                     break;
                 }
             }
-
             if (composite) return false;
         }
-
         return true;
     }
 
-    // Χڣ
+    // 生成随机的素数（范围内）
     static BigInt generatePrime(long long min, long long max) {
-        // ʹøõӣʱ豸
+        // 使用更好的随机种子：结合时间和随机设备
         std::random_device rd;
         auto seed = rd() ^ (
             static_cast<unsigned>(std::chrono::high_resolution_clock::now().time_since_epoch().count()) +
@@ -113,46 +329,330 @@ public:
         std::mt19937_64 gen(seed);
         std::uniform_int_distribution<long long> dis(min, max);
 
+        // 从随机起点开始筛一个窗口，只有不被小素数整除的候选数才做米勒-拉宾测试
         int attempts = 0;
         while (attempts < 10000) {
-            long long candidate = dis(gen);
-            if (candidate % 2 == 0) candidate++;
-            
-            BigInt n(candidate);
-            if (isProbablePrime(n)) {
-                return n;
-            }
             attempts++;
+            long long start = dis(gen);
+            if (start % 2 == 0) start++;
+            if (start > max) continue;
+
+            size_t window = (size_t)std::min<long long>(SIEVE_WINDOW, (max - start) / 2 + 1);
+            std::vector<bool> composite = sieveWindow(BigInt(start), window);
+            for (size_t j = 0; j < window; ++j) {
+                if (composite[j]) continue;
+                BigInt n(start + 2 * (long long)j);
+                if (isPrime64(n.toUint64())) {
+                    return n;
+                }
+            }
         }
         
-        // ҲҲԤ
+        // 如果也找不到，返回预设的素数
         return BigInt("1009");
     }
 
-    // С
+    // 生成随机的小素数
     static BigInt generateSmallPrime(int min = 100, int max = 10000) {
         return generatePrime(min, max);
     }
 
-    // ʾƼİȫ
+    // 显示推荐的安全级别
     static void displaySecurityLevels() {
-        std::cout << "ȫѡÿɣ" << std::endl;
-        std::cout << "0 - ʾ (p,q  [50, 100], n  10,000λ)" << std::endl;
-        std::cout << "1 - ͼ (p,q  [900, 1100], n  1,000,000λ)" << std::endl;
-        std::cout << "2 - м (p,q  [9000, 11000], n  100,000,000λ)" << std::endl;
-        std::cout << "3 - ߼ (p,q  [90000, 110000], n  10,000,000,000λ)" << std::endl;
-        std::cout << "4 - ߼ (p,q  [900000, 1100000], n  1,000,000,000,000λ)" << std::endl;
+        std::cout << "安全级别选项（每次随机生成）：" << std::endl;
+        std::cout << "0 - 演示级 (p,q ∈ [50, 100], n ≈ 10,000位)" << std::endl;
+        std::cout << "1 - 低级 (p,q ∈ [900, 1100], n ≈ 1,000,000位)" << std::endl;
+        std::cout << "2 - 中级 (p,q ∈ [9000, 11000], n ≈ 100,000,000位)" << std::endl;
+        std::cout << "3 - 高级 (p,q ∈ [90000, 110000], n ≈ 10,000,000,000位)" << std::endl;
+        std::cout << "4 - 极高级 (p,q ∈ [900000, 1100000], n ≈ 1,000,000,000,000位)" << std::endl;
+        std::cout << "5 - 512 位模数 (p,q 各 256 位，仅供测试)" << std::endl;
+        std::cout << "6 - 1024 位模数 (p,q 各 512 位)" << std::endl;
+        std::cout << "7 - 2048 位模数 (p,q 各 1024 位，推荐)" << std::endl;
+        std::cout << "8 - 3072 位模数 (p,q 各 1536 位)" << std::endl;
+        std::cout << "9 - 4096 位模数 (p,q 各 2048 位，生成较慢)" << std::endl;
     }
 
 private:
-    static BigInt getRandomBigInt(long long min, const BigInt& max, std::mt19937_64& gen) {
-        long long max_val = 1000000LL;
-        std::string max_str = max.toString();
-        if (max_str.length() <= 9) {
-            max_val = std::stoll(max_str);
+    // 64 位模数的 Montgomery 上下文，R = 2^64
+    struct Montgomery64 {
+        uint64_t n;
+        uint64_t nInv; // n^-1 mod 2^64
+        uint64_t r2;   // R^2 mod n
+
+        explicit Montgomery64(uint64_t modulus) : n(modulus) {
+            nInv = n;
+            for (int i = 0; i < 5; ++i) nInv *= 2 - n * nInv;
+            uint64_t r = (0 - n) % n;
+            r2 = (uint64_t)((unsigned __int128)r * r % n);
         }
-        
-        std::uniform_int_distribution<long long> dis(min, std::min(max_val, 999999LL));
-        return BigInt(dis(gen));
+
+        // t * R^-1 mod n：m = t * n^-1 使 t - m*n 的低 64 位为 0
+        uint64_t reduce(unsigned __int128 t) const {
+            uint64_t m = (uint64_t)t * nInv;
+            uint64_t hi = (uint64_t)(t >> 64);
+            uint64_t mn = (uint64_t)(((unsigned __int128)m * n) >> 64);
+            return hi >= mn ? hi - mn : hi - mn + n;
+        }
+
+        uint64_t multiply(uint64_t a, uint64_t b) const {
+            return reduce((unsigned __int128)a * b);
+        }
+
+        uint64_t one() const { return (0 - n) % n; }
+        uint64_t toMontgomery(uint64_t a) const { return multiply(a % n, r2); }
+
+        uint64_t pow(uint64_t base, uint64_t exp) const {
+            uint64_t result = one();
+            while (exp) {
+                if (exp & 1) result = multiply(result, base);
+                base = multiply(base, base);
+                exp >>= 1;
+            }
+            return result;
+        }
+    };
+
+    // 已通过小素数试除的奇数 n（n >= 2^64）的概率素性测试，所有轮次共享一个 Montgomery 上下文。
+    // 测试期间的临时大整数都从线程分配区取，返回时整体回收
+    static bool probablePrimeAfterSieve(const BigInt& n, int iterations = 0) {
+        LimbArena::Scope scope;
+        MontgomeryContext ctx(n);
+
+        // 将 n-1 写成 2^r * d 的形式
+        BigInt nMinusOne = n - BigInt(1);
+        size_t r = 0;
+        while (!nMinusOne.testBit(r)) r++;
+        BigInt d = nMinusOne >> r;
+        BigInt minusOne = ctx.toMontgomery(nMinusOne);
+
+        if (iterations <= 0) {
+            return strongProbablePrime(ctx, ctx.toMontgomery(BigInt(2)), d, r, minusOne) &&
+                   strongLucasProbablePrime(n, ctx);
+        }
+
+        std::mt19937_64 gen(makeSeed());
+        BigInt nMinusTwo = n - BigInt(2);
+        for (int i = 0; i < iterations; i++) {
+            // 随机选择基数 a ∈ [2, n-2]
+            BigInt a = getRandomBigInt(2, nMinusTwo, gen);
+            if (!strongProbablePrime(ctx, ctx.toMontgomery(a), d, r, minusOne)) return false;
+        }
+        return true;
+    }
+
+    // 以 a 为基的强伪素数测试（米勒-拉宾的一轮），aMont 和 minusOne 为 Montgomery 形式
+    static bool strongProbablePrime(const MontgomeryContext& ctx, const BigInt& aMont,
+                                    const BigInt& d, size_t r, const BigInt& minusOne) {
+        BigInt x = ctx.powMontgomery(aMont, d);
+        if (x == ctx.one() || x == minusOne) return true;
+
+        BigInt t;
+        for (size_t j = 1; j < r; j++) {
+            ctx.multiply(x, x, t);
+            x.swap(t);
+            if (x == minusOne) return true;
+        }
+        return false;
+    }
+
+    // 强 Lucas 概率素数测试（Selfridge 方法 A 选取参数 D, P = 1, Q = (1 - D) / 4）。
+    // 全部运算在 Montgomery 形式下进行；除以 2 对 Montgomery 形式同样成立。
+    static bool strongLucasProbablePrime(const BigInt& n, const MontgomeryContext& ctx) {
+        // 依次尝试 D = 5, -7, 9, -11, ...，直到 Jacobi(D/n) = -1；完全平方数找不到这样的 D
+        long long D = 5;
+        for (int tries = 0;; ++tries) {
+            int j = jacobi(D, n);
+            if (j == -1) break;
+            if (j == 0 && BigInt(D < 0 ? -D : D) != n) return false;
+            if (tries == 20 && isPerfectSquare(n)) return false;
+            D = D > 0 ? -(D + 2) : -D + 2;
+        }
+        long long Q = (1 - D) / 4;
+
+        auto toMont = [&](long long v) {
+            BigInt x(v < 0 ? -v : v);
+            x = ctx.toMontgomery(x);
+            return v < 0 && !x.isZero() ? n - x : x;
+        };
+        // 以下模加、模减、除以 2 都就地修改 a，循环中不再分配内存
+        auto addMod = [&](BigInt& a, const BigInt& b) {
+            a += b;
+            if (a >= n) a -= n;
+        };
+        auto subMod = [&](BigInt& a, const BigInt& b) {
+            a -= b;
+            if (a.sign() < 0) a += n;
+        };
+        auto half = [&](BigInt& a) {
+            if (a.isOdd()) a += n;
+            a >>= 1;
+        };
+
+        BigInt dM = toMont(D);
+        BigInt qM = toMont(Q);
+
+        // n + 1 = 2^s * k，k 为奇数
+        BigInt nPlusOne = n + BigInt(1);
+        size_t s = 0;
+        while (!nPlusOne.testBit(s)) s++;
+        BigInt k = nPlusOne >> s;
+
+        // 从最高位开始的二进制阶梯：U_1 = 1, V_1 = P = 1, Q^1
+        BigInt U = ctx.one();
+        BigInt V = ctx.one();
+        BigInt Qk = qM;
+        BigInt t, twoQk;
+        // V <- V^2 - 2Q^m
+        auto doubleV = [&]() {
+            ctx.multiply(V, V, t);
+            V.swap(t);
+            twoQk = Qk;
+            addMod(twoQk, Qk);
+            subMod(V, twoQk);
+        };
+        for (size_t i = k.bitLength() - 1; i-- > 0;) {
+            // 下标翻倍：U_2m = U_m V_m, V_2m = V_m^2 - 2Q^m
+            ctx.multiply(U, V, t);
+            U.swap(t);
+            doubleV();
+            ctx.multiply(Qk, Qk, t);
+            Qk.swap(t);
+            if (k.testBit(i)) {
+                // 下标加一：U_m+1 = (U_m + V_m) / 2, V_m+1 = (D U_m + V_m) / 2
+                ctx.multiply(dM, U, t);
+                addMod(U, V);
+                half(U);
+                addMod(t, V);
+                half(t);
+                V.swap(t);
+                ctx.multiply(Qk, qM, t);
+                Qk.swap(t);
+            }
+        }
+
+        if (U.isZero() || V.isZero()) return true;
+        for (size_t r = 1; r < s; ++r) {
+            doubleV();
+            if (V.isZero()) return true;
+            ctx.multiply(Qk, Qk, t);
+            Qk.swap(t);
+        }
+        return false;
+    }
+
+    // Jacobi 符号 (a/n)，n 为正奇数
+    static int jacobi(long long a, const BigInt& n) {
+        int result = 1;
+        uint64_t nMod8 = n.toUint64() & 7;
+        if (a < 0) {
+            a = -a;
+            if ((nMod8 & 3) == 3) result = -result; // (-1/n)
+        }
+        uint64_t x = (uint64_t)a;
+        while (x % 2 == 0 && x != 0) {
+            x /= 2;
+            if (nMod8 == 3 || nMod8 == 5) result = -result;
+        }
+        if (x == 0) return 0;
+        if (x == 1) return result;
+        // 二次互反律：(x/n) = (n/x) * (-1)^((x-1)/2 * (n-1)/2)
+        if ((x & 3) == 3 && (nMod8 & 3) == 3) result = -result;
+        return result * jacobi64(n.modSmall(x), x);
+    }
+
+    static int jacobi64(uint64_t a, uint64_t n) {
+        int result = 1;
+        a %= n;
+        while (a != 0) {
+            while (a % 2 == 0) {
+                a /= 2;
+                uint64_t r = n & 7;
+                if (r == 3 || r == 5) result = -result;
+            }
+            std::swap(a, n);
+            if ((a & 3) == 3 && (n & 3) == 3) result = -result;
+            a %= n;
+        }
+        return n == 1 ? result : 0;
+    }
+
+    // 牛顿迭代求整数平方根后判断是否为完全平方数
+    static bool isPerfectSquare(const BigInt& n) {
+        BigInt x = BigInt(1) << ((n.bitLength() + 1) / 2);
+        while (true) {
+            BigInt y = (x + n / x) >> 1;
+            if (y >= x) break;
+            x = y;
+        }
+        return x * x == n;
+    }
+
+    // 增量筛：对奇数起点 start，标记 start + 2j (0 <= j < window) 中能被小素数整除的合数。
+    // 每个小素数只需对 start 取一次模，之后按步长 p 在窗口内划掉倍数。
+    static std::vector<bool> sieveWindow(const BigInt& start, size_t window) {
+        std::vector<bool> composite(window, false);
+        bool smallStart = start.bitLength() < 32;
+        uint64_t startValue = start.toUint64();
+
+        // 窗口内的合数必有不超过 sqrt(窗口上界) 的素因子，更大的素数无需参与筛选
+        uint64_t windowEnd = smallStart ? startValue + 2 * window : UINT64_MAX;
+
+        for (size_t i = 1; i < SMALL_PRIME_COUNT; ++i) {
+            uint64_t p = SMALL_PRIMES[i];
+            if (smallStart && p * p > windowEnd) break;
+            uint64_t r = smallStart ? startValue % p : start.modSmall(p);
+            // 解 start + 2j ≡ 0 (mod p)，即 j ≡ (p - r) * 2^-1 (mod p)
+            uint64_t j = (p - r) % p * ((p + 1) / 2) % p;
+            for (; j < window; j += p) {
+                if (smallStart && startValue + 2 * j == p) continue; // 小素数本身不是合数
+                composite[j] = true;
+            }
+        }
+        return composite;
+    }
+
+    // 把 modulusBits 尽量平均地分给 count 个素数，多出的位分给前面的素数
+    static std::vector<size_t> balancedPrimeBits(size_t modulusBits, size_t count) {
+        if (count < 2 || modulusBits / count < 8) {
+            throw std::invalid_argument("modulus too small for the requested number of primes");
+        }
+        std::vector<size_t> bits(count, modulusBits / count);
+        for (size_t i = 0; i < modulusBits % count; ++i) ++bits[i];
+        return bits;
+    }
+
+    // 需要重新生成的素数下标：与前面某个素数相同的那个；乘积位数不足时按 attempt 轮流选一个
+    // （只换最后一个不一定够，前面的素数都偏小时需要换掉它们）。都满足时返回 size()
+    static size_t unusablePrime(const std::vector<BigInt>& primes, size_t modulusBits, size_t attempt) {
+        BigInt product(1);
+        for (size_t i = 0; i < primes.size(); ++i) {
+            for (size_t j = 0; j < i; ++j) {
+                if (primes[j] == primes[i]) return i;
+            }
+            product *= primes[i];
+        }
+        if (product.bitLength() == modulusBits) return primes.size();
+        return primes.size() - 1 - attempt % primes.size();
+    }
+
+    // bits 位的随机奇数，最高两位为 1
+    template <typename URBG>
+    static BigInt randomPrimeStart(size_t bits, URBG& gen) {
+        BigInt start = BigInt::random(bits, gen);
+        start.setBit(bits - 1);
+        start.setBit(bits - 2);
+        start.setBit(0);
+        return start;
+    }
+
+    static BigInt getRandomBigInt(long long min, const BigInt& max, std::mt19937_64& gen) {
+        return BigInt::randomRange(BigInt(min), max, gen);
+    }
+
+    // 结合随机设备和时间生成随机种子
+    static uint64_t makeSeed() {
+        std::random_device rd;
+        uint64_t seed = ((uint64_t)rd() << 32) ^ rd();
+        return seed ^ (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
     }
 };
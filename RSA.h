@@ -1,173 +1,1034 @@
 #pragma once
 #include "BigInt.h"
 #include "KeyManager.h"
+#include "ThreadPool.h"
+#include "ChaCha20Poly1305.h"
+#include "SHA256.h"
+#include "SystemRandom.h"
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <random>
 #include <ctime>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <numeric>
 
+// 不可变的密钥上下文：密钥数值以及由它派生的 CRT 参数、Montgomery 上下文和逐字节查表缓存。
+// 构造后不再修改，多个线程可以通过 shared_ptr 共享同一个对象而无需加锁；
+// 换密钥时构造新的上下文整体替换，旧对象在最后一个使用者释放后销毁。
+class RSAKey {
+public:
+    RSAKey() {}
+
+    // 从密钥数值构造。p、q 及 otherPrimes 中的素因子之积等于 n 时启用 CRT
+    // （缺失的 CRT 指数和系数由 d 推导），否则丢弃全部 CRT 参数
+    explicit RSAKey(const KeyManager::KeyData& data)
+        : e(data.e), d(data.d), n(data.n), p(data.p), q(data.q), dP(data.dP), dQ(data.dQ), qInv(data.qInv) {
+        if (n.isOdd() && n > 1) {
+            nCtx = std::make_shared<const MontgomeryContext>(n);
+        }
+
+        if (primesMatch(data)) {
+            if (dP.isZero() || dQ.isZero() || qInv.isZero()) {
+                dP = d % (p - BigInt(1));
+                dQ = d % (q - BigInt(1));
+                qInv = BigInt::modInverse(q % p, p);
+            }
+            pCtx = std::make_shared<const MontgomeryContext>(p);
+            qCtx = std::make_shared<const MontgomeryContext>(q);
+
+            BigInt prefix = p * q;
+            for (const KeyManager::PrimeInfo& info : data.otherPrimes) {
+                ExtraPrime extra;
+                extra.r = info.r;
+                extra.d = info.d;
+                extra.t = info.t;
+                if (extra.d.isZero() || extra.t.isZero()) {
+                    extra.d = d % (extra.r - BigInt(1));
+                    extra.t = BigInt::modInverse(prefix % extra.r, extra.r);
+                }
+                extra.prefix = prefix;
+                extra.ctx = std::make_shared<const MontgomeryContext>(extra.r);
+                prefix *= extra.r;
+                extras.push_back(std::move(extra));
+            }
+        } else {
+            p = q = dP = dQ = qInv = BigInt();
+        }
+    }
+
+    RSAKey(const RSAKey&) = delete;
+    RSAKey& operator=(const RSAKey&) = delete;
+
+    // 由两个素数生成完整的密钥对
+    static std::shared_ptr<const RSAKey> fromPrimes(const BigInt& p, const BigInt& q) {
+        return fromPrimes(std::vector<BigInt>{p, q});
+    }
+
+    // 由两个或更多互不相同的素数生成密钥对（多素数 RSA）。素因子越多，每次 CRT 模幂的操作数越短
+    static std::shared_ptr<const RSAKey> fromPrimes(const std::vector<BigInt>& primes) {
+        if (primes.size() < 2) throw std::runtime_error("至少需要两个素因子！");
+        KeyManager::KeyData data;
+        // 计算 n = r_1 * r_2 * ... 和欧拉函数 φ(n) = (r_1-1)(r_2-1)...
+        data.n = BigInt(1);
+        BigInt phi(1);
+        for (const BigInt& r : primes) {
+            data.n *= r;
+            phi *= r - BigInt(1);
+        }
+
+        // 选择公钥指数 e (通常选择65537)
+        data.e = BigInt(65537);
+
+        // 确保 e 与 φ(n) 互质
+        while (!BigInt::gcd(data.e, phi).isOne()) {
+            data.e += BigInt(2);
+        }
+
+        // 计算私钥指数 d = e^(-1) mod φ(n)
+        data.d = BigInt::modInverse(data.e, phi);
+
+        // 保留 CRT 参数，私钥运算时在各素因子上分别做短模幂
+        data.p = primes[0];
+        data.q = primes[1];
+        for (size_t i = 2; i < primes.size(); ++i) {
+            data.otherPrimes.push_back({primes[i], BigInt(), BigInt()});
+        }
+        return std::make_shared<const RSAKey>(data);
+    }
+
+    // 导出全部密钥数值，用于保存或在此基础上构造新的上下文
+    KeyManager::KeyData data() const {
+        KeyManager::KeyData result;
+        result.e = e;
+        result.d = d;
+        result.n = n;
+        result.p = p;
+        result.q = q;
+        result.dP = dP;
+        result.dQ = dQ;
+        result.qInv = qInv;
+        for (const ExtraPrime& extra : extras) {
+            result.otherPrimes.push_back({extra.r, extra.d, extra.t});
+        }
+        return result;
+    }
+
+    std::pair<BigInt, BigInt> getPublicKey() const {
+        return {e, n};
+    }
+
+    std::pair<BigInt, BigInt> getPrivateKey() const {
+        return {d, n};
+    }
+
+    bool hasPublicKey() const {
+        return !e.isZero() && !n.isZero();
+    }
+
+    bool hasPrivateKey() const {
+        return !d.isZero() && !n.isZero();
+    }
+
+    // 私钥是否带有可用的 CRT 参数
+    bool hasCrtParams() const {
+        return pCtx && qCtx;
+    }
+
+    // CRT 使用的素因子个数，没有 CRT 参数时为 0
+    size_t primeCount() const {
+        return hasCrtParams() ? 2 + extras.size() : 0;
+    }
+
+    // Block 模式下每块可容纳的明文字节数，保证打包后的整数小于 n
+    size_t blockBytes() const {
+        size_t bits = n.bitLength();
+        return bits > 0 ? (bits - 1) / 8 : 0;
+    }
+
+    // 每块密文的定长字节数
+    size_t cipherBytes() const {
+        return (n.bitLength() + 7) / 8;
+    }
+
+    // 公钥运算 m^e mod n。e 不超过 64 位时（通常为 65537）走短指数路径，只做 16 次平方和 1 次乘法
+    BigInt publicPow(const BigInt& m) const {
+        if (nCtx && e.bitLength() <= 64) return nCtx->pow(m, e.toUint64());
+        return powModN(m, e);
+    }
+
+    // 私钥运算 c^d mod n：有 CRT 参数时在每个素因子上各做一次短模幂，再用 Garner 公式重组。
+    // 多素数时按 RFC 8017 5.1.2 依次并入第 3 个及以后的素因子
+    BigInt privatePow(const BigInt& c) const {
+        if (!hasCrtParams()) return powModN(c, d);
+        BigInt m1 = BigInt::modPow(c, dP, *pCtx);
+        BigInt m2 = BigInt::modPow(c, dQ, *qCtx);
+        BigInt h = (qInv * (m1 - m2)) % p;
+        BigInt m = m2 + h * q;
+        for (const ExtraPrime& extra : extras) {
+            BigInt mi = BigInt::modPow(c, extra.d, *extra.ctx);
+            h = (extra.t * (mi - m % extra.r)) % extra.r;
+            m += extra.prefix * h;
+        }
+        return m;
+    }
+
+    // RSASSA-PKCS1-v1_5 签名（RFC 8017），返回 cipherBytes() 字节的大端签名。
+    // 有公钥时用公钥验算一次结果，防止 CRT 运算出错泄露素因子
+    std::string signDigest(const SHA256::Digest& digest) const {
+        size_t k = cipherBytes();
+        if (k < SIGNATURE_MIN_BYTES) throw std::runtime_error("模数太小，无法签名！");
+        std::vector<unsigned char> em(k);
+        encodeDigest(digest, em.data(), k);
+        LimbArena::Scope scope;
+        BigInt m = BigInt::fromBytes(em.data(), k);
+        BigInt s = privatePow(m);
+        if (hasPublicKey() && publicPow(s) != m) throw std::runtime_error("签名自检失败！");
+        std::string signature(k, '\0');
+        s.toBytes(reinterpret_cast<unsigned char*>(&signature[0]), k);
+        return signature;
+    }
+
+    // 验证 signDigest 产生的签名；长度不符、签名值不小于 n 或填充不符时返回 false
+    bool verifyDigest(const SHA256::Digest& digest, const unsigned char* signature, size_t len) const {
+        size_t k = cipherBytes();
+        if (!hasPublicKey() || k < SIGNATURE_MIN_BYTES || len != k) return false;
+        LimbArena::Scope scope;
+        BigInt s = BigInt::fromBytes(signature, len);
+        if (s >= n) return false;
+        std::vector<unsigned char> em(k);
+        encodeDigest(digest, em.data(), k);
+        return publicPow(s) == BigInt::fromBytes(em.data(), k);
+    }
+
+private:
+    friend class RSA;
+
+    BigInt e; // 公钥指数
+    BigInt d; // 私钥指数
+    BigInt n; // 模数
+    std::shared_ptr<const MontgomeryContext> nCtx; // 模数 n 的 Montgomery 上下文（n 为奇数时有效）
+
+    // CRT 私钥参数（未知时为 0）
+    BigInt p, q;    // 素因子
+    BigInt dP, dQ;  // d mod (p-1), d mod (q-1)
+    BigInt qInv;    // q^-1 mod p
+    std::shared_ptr<const MontgomeryContext> pCtx, qCtx;
+
+    // 多素数密钥的第 3 个及以后的素因子（两素数密钥为空）
+    struct ExtraPrime {
+        BigInt r, d, t;  // 素因子、d mod (r-1)、prefix^-1 mod r
+        BigInt prefix;   // 之前各素因子之积
+        std::shared_ptr<const MontgomeryContext> ctx;
+    };
+    std::vector<ExtraPrime> extras;
+
+    // 全部素因子都是大于 1 的奇数、两两不同，且乘积等于 n
+    static bool primesMatch(const KeyManager::KeyData& data) {
+        if (data.d.isZero() || data.p.isZero() || data.q.isZero()) return false;
+        std::vector<const BigInt*> primes = {&data.p, &data.q};
+        for (const KeyManager::PrimeInfo& info : data.otherPrimes) primes.push_back(&info.r);
+        BigInt product(1);
+        for (size_t i = 0; i < primes.size(); ++i) {
+            if (!primes[i]->isOdd() || *primes[i] <= 1) return false;
+            for (size_t j = 0; j < i; ++j) {
+                if (*primes[j] == *primes[i]) return false;
+            }
+            product *= *primes[i];
+        }
+        return product == data.n;
+    }
+
+    // 逐字节模式的查表缓存：每个字节值的密文，以及密文到字节的反向索引
+    struct ByteTable {
+        std::string cipher[256];
+        std::unordered_map<std::string_view, unsigned char> plain; // 键指向 cipher 中的字符串
+    };
+    mutable std::shared_ptr<const ByteTable> byteTable; // 首次使用时构建
+
+    // EMSA-PKCS1-v1_5 编码：00 01 FF..FF 00 || SHA-256 的 DigestInfo || 摘要，填充至少 8 个 FF
+    static constexpr unsigned char SHA256_DIGEST_INFO[19] = {
+        0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20,
+    };
+    static constexpr size_t SIGNATURE_MIN_BYTES = 11 + sizeof(SHA256_DIGEST_INFO) + 32;
+
+    static void encodeDigest(const SHA256::Digest& digest, unsigned char* em, size_t k) {
+        size_t t = sizeof(SHA256_DIGEST_INFO) + digest.size();
+        em[0] = 0x00;
+        em[1] = 0x01;
+        std::fill(em + 2, em + k - t - 1, 0xff);
+        em[k - t - 1] = 0x00;
+        std::memcpy(em + k - t, SHA256_DIGEST_INFO, sizeof(SHA256_DIGEST_INFO));
+        std::memcpy(em + k - digest.size(), digest.data(), digest.size());
+    }
+
+    // 多个线程同时首次使用时可能各自构建一次，结果相同，以最后写入的为准
+    std::shared_ptr<const ByteTable> getByteTable() const {
+        std::shared_ptr<const ByteTable> table = std::atomic_load(&byteTable);
+        if (table) return table;
+
+        std::shared_ptr<ByteTable> built = std::make_shared<ByteTable>();
+        built->plain.reserve(256);
+        for (int b = 0; b < 256; ++b) {
+            built->cipher[b] = powModN(BigInt(b), e).toString();
+            built->plain.emplace(built->cipher[b], (unsigned char)b);
+        }
+        table = built;
+        std::atomic_store(&byteTable, table);
+        return table;
+    }
+
+    BigInt powModN(const BigInt& base, const BigInt& exp) const {
+        if (nCtx) return BigInt::modPow(base, exp, *nCtx);
+        return BigInt::modPow(base, exp, n);
+    }
+};
+
+// RSA 加解密。当前密钥是一个 RSAKey 快照，通过 shared_ptr 的原子读写发布（RCU 方式）：
+// 每次加解密开始时取一次快照，全程只使用这一份密钥；setKeyContext、loadKeys 等写操作构造新的上下文后
+// 原子替换指针，不影响正在进行的运算。因此同一个 RSA 对象可以在多个线程间共享，并在运行中热切换密钥。
 class RSA {
 public:
-    RSA() : e(0), d(0), n(0) {}
+    using KeyPtr = std::shared_ptr<const RSAKey>;
+
+    RSA() : key(std::make_shared<const RSAKey>()) {}
+
+    explicit RSA(KeyPtr context) : key(context ? std::move(context) : std::make_shared<const RSAKey>()) {}
+
+    RSA(const RSA& other) : key(other.keyContext()) {}
 
-    // ʹԤʼRSA (ʾ)
+    RSA& operator=(const RSA& other) {
+        setKeyContext(other.keyContext());
+        return *this;
+    }
+
+    // 当前密钥上下文的快照；持有期间即使密钥被替换，快照本身也保持有效
+    KeyPtr keyContext() const {
+        return std::atomic_load(&key);
+    }
+
+    // 原子替换当前密钥，之后开始的加解密使用新密钥；传入空指针表示清空密钥
+    void setKeyContext(KeyPtr context) {
+        if (!context) context = std::make_shared<const RSAKey>();
+        std::atomic_store(&key, std::move(context));
+    }
+
+    // 从文件加载一对密钥并构造上下文，失败（文件缺失或公私钥模数不一致）时返回空指针。
+    // 可以在后台线程中加载，完成后再用 setKeyContext 切换
+    static KeyPtr loadKeyContext(const std::string& publicKeyFile = "public_key.txt",
+                                 const std::string& privateKeyFile = "private_key.txt") {
+        KeyManager::KeyData data;
+        BigInt n_pub;
+        bool pub_loaded = KeyManager::loadPublicKey(data.e, n_pub, publicKeyFile);
+        bool priv_loaded = KeyManager::loadPrivateKey(data, privateKeyFile);
+        if (!pub_loaded || !priv_loaded || n_pub != data.n) return nullptr;
+        return std::make_shared<const RSAKey>(data);
+    }
+
+    // 使用预定义的素数初始化RSA (用于演示)
     void initialize(const BigInt& p, const BigInt& q) {
-        //  n = p * q
-        n = p * q;
-        
-        // ŷ (n) = (p-1)(q-1)
-        BigInt phi = (p - BigInt(1)) * (q - BigInt(1));
-        
-        // ѡԿָ e (ͨѡ65537)
-        e = BigInt(65537);
-        
-        // ȷ e  (n) 
-        while (BigInt::gcd(e, phi) != BigInt(1)) {
-            e = e + BigInt(2);
-        }
-        
-        // ˽Կָ d = e^(-1) mod (n)
-        d = BigInt::modInverse(e, phi);
+        setKeyContext(RSAKey::fromPrimes(p, q));
+    }
+
+    // 用两个或更多素数初始化多素数 RSA，素数可由 PrimeGenerator::getPrimesBits 生成
+    void initialize(const std::vector<BigInt>& primes) {
+        setKeyContext(RSAKey::fromPrimes(primes));
     }
 
-    // ùԿֻܵĳ
+    // 设置公钥（用于只加密的场景）
     void setPublicKey(const BigInt& e_val, const BigInt& n_val) {
-        e = e_val;
-        n = n_val;
+        updateKey([&](KeyManager::KeyData& data) {
+            data.e = e_val;
+            data.n = n_val;
+        });
     }
 
-    // ˽Կֻܵĳ
+    // 设置私钥（用于只解密的场景）
     void setPrivateKey(const BigInt& d_val, const BigInt& n_val) {
-        d = d_val;
-        n = n_val;
+        updateKey([&](KeyManager::KeyData& data) {
+            data.d = d_val;
+            data.n = n_val;
+            data.p = data.q = data.dP = data.dQ = data.qInv = BigInt();
+            data.otherPrimes.clear();
+        });
     }
 
-    // Կļ
+    // 保存密钥到文件；加载时会自动识别文本和二进制格式
     bool saveKeys(const std::string& publicKeyFile = "public_key.txt",
-                  const std::string& privateKeyFile = "private_key.txt") const {
-        bool pub_saved = KeyManager::savePublicKey(e, n, publicKeyFile);
-        bool priv_saved = KeyManager::savePrivateKey(d, n, privateKeyFile);
+                  const std::string& privateKeyFile = "private_key.txt",
+                  KeyManager::Format format = KeyManager::Format::Text) const {
+        KeyPtr current = keyContext();
+        const RSAKey& k = *current;
+        if (format == KeyManager::Format::Binary) {
+            KeyManager::KeyData pub;
+            pub.e = k.e;
+            pub.n = k.n;
+            KeyManager::KeyData priv = k.data();
+            priv.e = BigInt();
+            bool pub_saved = KeyManager::saveBinaryKey(pub, publicKeyFile);
+            bool priv_saved = KeyManager::saveBinaryKey(priv, privateKeyFile);
+            return pub_saved && priv_saved;
+        }
+        bool pub_saved = KeyManager::savePublicKey(k.e, k.n, publicKeyFile);
+        bool priv_saved = KeyManager::savePrivateKey(k.data(), privateKeyFile);
         return pub_saved && priv_saved;
     }
 
-    // ļԿ
+    // 从文件加载密钥，成功后原子替换当前密钥
     bool loadKeys(const std::string& publicKeyFile = "public_key.txt",
                   const std::string& privateKeyFile = "private_key.txt") {
-        BigInt e_temp, d_temp, n_pub, n_priv;
-        
-        bool pub_loaded = KeyManager::loadPublicKey(e_temp, n_pub, publicKeyFile);
-        bool priv_loaded = KeyManager::loadPrivateKey(d_temp, n_priv, privateKeyFile);
-        
-        if (pub_loaded && priv_loaded && n_pub == n_priv) {
-            e = e_temp;
-            d = d_temp;
-            n = n_pub;
-            return true;
-        }
-        return false;
+        KeyPtr loaded = loadKeyContext(publicKeyFile, privateKeyFile);
+        if (!loaded) return false;
+        setKeyContext(std::move(loaded));
+        return true;
     }
 
-    // ֻعԿ
+    // 只加载公钥
     bool loadPublicKey(const std::string& publicKeyFile = "public_key.txt") {
-        return KeyManager::loadPublicKey(e, n, publicKeyFile);
+        BigInt e_temp, n_temp;
+        if (!KeyManager::loadPublicKey(e_temp, n_temp, publicKeyFile)) return false;
+        setPublicKey(e_temp, n_temp);
+        return true;
     }
 
-    // ֻ˽Կ
+    // 只加载私钥
     bool loadPrivateKey(const std::string& privateKeyFile = "private_key.txt") {
-        return KeyManager::loadPrivateKey(d, n, privateKeyFile);
+        KeyManager::KeyData loaded;
+        if (!KeyManager::loadPrivateKey(loaded, privateKeyFile)) {
+            return false;
+        }
+        updateKey([&](KeyManager::KeyData& data) {
+            loaded.e = data.e;
+            data = loaded;
+        });
+        return true;
     }
 
-    // ַ
-    std::string encrypt(const std::string& plaintext) const {
-        if (e.isZero() || n.isZero()) {
-            throw std::runtime_error("Կδã");
+    // 加密模式
+    enum class Mode {
+        PerByte, // 每个字节单独加密（旧格式，保持与其他程序互通）
+        Block,   // 把尽可能多的字节打包进一个小于 n 的整数，密文以 "B<明文字节数>" 开头
+        Binary,  // 与 Block 相同的分块，但输出定长二进制分帧格式（不可打印），与流式接口通用
+        Hybrid   // 混合加密：RSA 只封装随机会话密钥，数据用 ChaCha20-Poly1305 加密并认证（二进制）
+    };
+
+    // 加密字符串
+    std::string encrypt(const std::string& plaintext, Mode mode = Mode::PerByte) const {
+        return encryptImpl(*keyContext(), plaintext, mode, nullptr, 0);
+    }
+
+    // 解密字符串（自动识别密文模式，包括二进制和混合加密格式）
+    std::string decrypt(const std::string& ciphertext) const {
+        return decryptImpl(*keyContext(), ciphertext, nullptr, 0);
+    }
+
+    // 多线程加密：各块的模幂互不依赖，按块分发到线程池后按原顺序拼接
+    std::string encrypt(const std::string& plaintext, ThreadPool& pool,
+                        Mode mode = Mode::PerByte, size_t chunkSize = 0) const {
+        return encryptImpl(*keyContext(), plaintext, mode, &pool, chunkSize);
+    }
+
+    // 多线程解密：密文块的解析和私钥运算都在线程池中完成
+    std::string decrypt(const std::string& ciphertext, ThreadPool& pool, size_t chunkSize = 0) const {
+        return decryptImpl(*keyContext(), ciphertext, &pool, chunkSize);
+    }
+
+    // 流式加密：按帧读取明文，每帧约 STREAM_FRAME_BYTES 字节，内存占用与输入长度无关。
+    // 输出为二进制分帧格式（见 Mode::Binary），返回处理的明文字节数
+    uint64_t encrypt(std::istream& in, std::ostream& out) const {
+        return encryptStream(*keyContext(), in, out, nullptr);
+    }
+
+    // 流式解密：读取 encrypt(std::istream&, std::ostream&) 或 encryptHybrid 产生的二进制密文，返回写出的明文字节数
+    uint64_t decrypt(std::istream& in, std::ostream& out) const {
+        return decryptStream(*keyContext(), in, out, nullptr);
+    }
+
+    // 多线程流式加解密：每帧内的各块分发到线程池
+    uint64_t encrypt(std::istream& in, std::ostream& out, ThreadPool& pool) const {
+        return encryptStream(*keyContext(), in, out, &pool);
+    }
+
+    uint64_t decrypt(std::istream& in, std::ostream& out, ThreadPool& pool) const {
+        return decryptStream(*keyContext(), in, out, &pool);
+    }
+
+    // 流式混合加密：整条消息只做一次 RSA 公钥运算，数据本体的速度与密钥长度无关。
+    // decrypt(std::istream&, std::ostream&) 根据魔数自动识别，返回处理的明文字节数
+    uint64_t encryptHybrid(std::istream& in, std::ostream& out) const {
+        return encryptHybridStream(*keyContext(), in, out, nullptr);
+    }
+
+    // 多线程混合加密：各帧分发到线程池
+    uint64_t encryptHybrid(std::istream& in, std::ostream& out, ThreadPool& pool) const {
+        return encryptHybridStream(*keyContext(), in, out, &pool);
+    }
+
+    // 用私钥对消息签名（RSASSA-PKCS1-v1_5 + SHA-256），返回与模数等长的二进制签名
+    std::string sign(const std::string& message) const {
+        return signWith(*keyContext(), SHA256::hash(message));
+    }
+
+    // 对输入流的全部内容签名，按帧读取，内存占用与输入长度无关
+    std::string sign(std::istream& in) const {
+        return signWith(*keyContext(), hashStream(in));
+    }
+
+    // 用公钥验证签名，签名无效时返回 false
+    bool verify(const std::string& message, const std::string& signature) const {
+        return verifyWith(*keyContext(), SHA256::hash(message), signature);
+    }
+
+    bool verify(std::istream& in, const std::string& signature) const {
+        return verifyWith(*keyContext(), hashStream(in), signature);
+    }
+
+    // verifyMany 的一项：key 为空或没有公钥时视为无效
+    struct SignatureCheck {
+        KeyPtr key;
+        std::string_view message;
+        std::string_view signature;
+        bool valid = false; // 由 verifyMany 填写
+    };
+
+    // 批量验证签名，结果写入各项的 valid，返回有效签名的个数。
+    // 各项按密钥排序后依次处理，同一密钥的验证连续进行，共用该密钥上下文中的 Montgomery 参数；
+    // 公钥指数较小时每次验证只需十几次模乘
+    static size_t verifyMany(std::vector<SignatureCheck>& checks) {
+        return verifyManyImpl(checks, nullptr);
+    }
+
+    // 多线程批量验证：排序后的各项按连续区间分发到线程池，每个区间内的密钥大多相同
+    static size_t verifyMany(std::vector<SignatureCheck>& checks, ThreadPool& pool) {
+        return verifyManyImpl(checks, &pool);
+    }
+
+    // Block 模式下每块可容纳的明文字节数，保证打包后的整数小于 n
+    size_t blockBytes() const {
+        return keyContext()->blockBytes();
+    }
+
+    // 获取公钥
+    std::pair<BigInt, BigInt> getPublicKey() const {
+        return keyContext()->getPublicKey();
+    }
+
+    // 获取私钥
+    std::pair<BigInt, BigInt> getPrivateKey() const {
+        return keyContext()->getPrivateKey();
+    }
+
+    // 显示密钥信息
+    void displayKeys() const {
+        KeyPtr k = keyContext();
+        std::cout << "=== RSA 密钥信息 ===" << std::endl;
+        std::cout << "公钥 (e, n):" << std::endl;
+        std::cout << "  e = " << k->e << std::endl;
+        std::cout << "  n = " << k->n << std::endl;
+        std::cout << "私钥 (d, n):" << std::endl;
+        std::cout << "  d = " << k->d << std::endl;
+        std::cout << "  n = " << k->n << std::endl;
+        std::cout << "=====================" << std::endl;
+    }
+
+    // 检查密钥是否已设置
+    bool hasPublicKey() const {
+        return keyContext()->hasPublicKey();
+    }
+
+    bool hasPrivateKey() const {
+        return keyContext()->hasPrivateKey();
+    }
+
+    // 私钥是否带有可用的 CRT 参数
+    bool hasCrtParams() const {
+        return keyContext()->hasCrtParams();
+    }
+
+private:
+    KeyPtr key; // 当前密钥，只通过 std::atomic_load / std::atomic_store 访问
+
+    // 以当前密钥为基础修改部分数值后发布新的上下文。与其他写操作并发时用比较交换重试，不会丢失更新
+    template <typename F>
+    void updateKey(F modify) {
+        KeyPtr current = keyContext();
+        KeyPtr next;
+        do {
+            KeyManager::KeyData data = current->data();
+            modify(data);
+            next = std::make_shared<const RSAKey>(data);
+        } while (!std::atomic_compare_exchange_weak(&key, &current, next));
+    }
+
+    // 二进制密文格式（多字节整数均为小端）：
+    //   0   魔数 "RSAC"
+    //   4   u8 版本号（当前为 1），随后 3 字节保留
+    //   8   u32 每块明文字节数 k（= RSAKey::blockBytes()）
+    //   12  u32 每块密文字节数 c（= n 的字节数）
+    //   16  若干帧：u32 本帧明文字节数 len，随后 ceil(len / k) 个 c 字节的大端密文块；
+    //       len 为 0 的帧表示结束
+    static constexpr char STREAM_MAGIC[4] = {'R', 'S', 'A', 'C'};
+    static constexpr unsigned char STREAM_VERSION = 1;
+    static constexpr size_t STREAM_HEADER_SIZE = 16;
+    static constexpr size_t STREAM_FRAME_BYTES = 64 * 1024;  // 加密时每帧的明文上限
+    static constexpr uint32_t STREAM_MAX_FRAME = 16u << 20;  // 解密时接受的单帧上限
+
+    static void putLE32(unsigned char* out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) out[i] = (unsigned char)(v >> (8 * i));
+    }
+
+    static uint32_t getLE32(const unsigned char* in) {
+        return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+    }
+
+    uint64_t encryptStream(const RSAKey& snapshot, std::istream& in, std::ostream& out, ThreadPool* pool,
+                           size_t chunkSize = 0) const {
+        if (!snapshot.hasPublicKey()) {
+            throw std::runtime_error("公钥未设置！");
         }
+        size_t k = snapshot.blockBytes();
+        size_t c = snapshot.cipherBytes();
+        if (k == 0) throw std::runtime_error("模数太小，无法使用分组模式！");
 
-        std::vector<BigInt> encrypted;
-        
-        for (char c : plaintext) {
-            BigInt m((long long)(unsigned char)c);
-            BigInt cipher = BigInt::modPow(m, e, n);
-            encrypted.push_back(cipher);
+        unsigned char header[STREAM_HEADER_SIZE] = {0};
+        std::memcpy(header, STREAM_MAGIC, 4);
+        header[4] = STREAM_VERSION;
+        putLE32(header + 8, (uint32_t)k);
+        putLE32(header + 12, (uint32_t)c);
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+        size_t blocksPerFrame = std::max<size_t>(1, STREAM_FRAME_BYTES / k);
+        // 明文缓冲区不做零初始化；密文缓冲区按实际帧长增长，短消息不会分配整帧
+        std::unique_ptr<unsigned char[]> plain(new unsigned char[blocksPerFrame * k]);
+        std::vector<unsigned char> cipher;
+        uint64_t total = 0;
+        while (in) {
+            in.read(reinterpret_cast<char*>(plain.get()), (std::streamsize)(blocksPerFrame * k));
+            size_t got = (size_t)in.gcount();
+            if (got == 0) break;
+            size_t blocks = (got + k - 1) / k;
+            std::fill(plain.get() + got, plain.get() + blocks * k, 0);
+
+            cipher.resize(4 + blocks * c);
+            putLE32(cipher.data(), (uint32_t)got);
+            runBlocks(pool, blocks, chunkSize, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    LimbArena::Scope scope; // 每块的临时大整数在块结束时整体回收
+                    BigInt m = BigInt::fromBytes(&plain[i * k], k);
+                    snapshot.publicPow(m).toBytes(&cipher[4 + i * c], c);
+                }
+            });
+            out.write(reinterpret_cast<const char*>(cipher.data()), (std::streamsize)cipher.size());
+            total += got;
         }
-        
-        // ܽתΪַ
-        std::string result;
-        for (size_t i = 0; i < encrypted.size(); ++i) {
-            if (i > 0) result += " ";
-            result += encrypted[i].toString();
+
+        unsigned char end[4] = {0};
+        out.write(reinterpret_cast<const char*>(end), 4);
+        if (!out) throw std::runtime_error("写入密文失败！");
+        return total;
+    }
+
+    uint64_t decryptStream(const RSAKey& snapshot, std::istream& in, std::ostream& out, ThreadPool* pool,
+                           size_t chunkSize = 0) const {
+        if (!snapshot.hasPrivateKey()) {
+            throw std::runtime_error("私钥未设置！");
         }
-        
-        return result;
+        size_t k = snapshot.blockBytes();
+        size_t c = snapshot.cipherBytes();
+
+        // 先读魔数，混合加密的密文交给 decryptHybridStream
+        unsigned char header[STREAM_HEADER_SIZE];
+        if (!in.read(reinterpret_cast<char*>(header), 4)) {
+            throw std::runtime_error("不是有效的二进制密文！");
+        }
+        if (std::memcmp(header, HYBRID_MAGIC, 4) == 0) {
+            return decryptHybridStream(snapshot, in, out, pool);
+        }
+        // 混合加密不受分块长度限制；分块密文同 encryptStream，要求每块至少一个字节
+        if (k == 0) throw std::runtime_error("模数太小，无法使用分组模式！");
+        if (std::memcmp(header, STREAM_MAGIC, 4) != 0 ||
+            !in.read(reinterpret_cast<char*>(header + 4), sizeof(header) - 4) || header[4] != STREAM_VERSION) {
+            throw std::runtime_error("不是有效的二进制密文！");
+        }
+        if (getLE32(header + 8) != k || getLE32(header + 12) != c) {
+            throw std::runtime_error("密文与当前密钥的分块长度不符！");
+        }
+
+        std::vector<unsigned char> cipher, plain;
+        uint64_t total = 0;
+        while (true) {
+            unsigned char lenBytes[4];
+            if (!in.read(reinterpret_cast<char*>(lenBytes), 4)) {
+                throw std::runtime_error("密文不完整！");
+            }
+            uint32_t len = getLE32(lenBytes);
+            if (len == 0) break;
+            if (len > STREAM_MAX_FRAME) throw std::runtime_error("密文帧长度超出范围！");
+
+            size_t blocks = (len + k - 1) / k;
+            cipher.resize(blocks * c);
+            plain.resize(blocks * k);
+            if (!in.read(reinterpret_cast<char*>(cipher.data()), (std::streamsize)cipher.size())) {
+                throw std::runtime_error("密文不完整！");
+            }
+            runBlocks(pool, blocks, chunkSize, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    LimbArena::Scope scope;
+                    BigInt cb = BigInt::fromBytes(&cipher[i * c], c);
+                    if (cb >= snapshot.n) throw std::runtime_error("密文块超出模数范围！");
+                    snapshot.privatePow(cb).toBytes(&plain[i * k], k);
+                }
+            });
+            out.write(reinterpret_cast<const char*>(plain.data()), len);
+            total += len;
+        }
+        if (!out) throw std::runtime_error("写入明文失败！");
+        return total;
     }
 
-    // ַ
-    std::string decrypt(const std::string& ciphertext) const {
-        if (d.isZero() || n.isZero()) {
-            throw std::runtime_error("˽Կδã");
+    // 混合加密格式（多字节整数均为小端）：
+    //   0   魔数 "RSAH"
+    //   4   u8 版本号（当前为 1），随后 3 字节保留
+    //   8   u32 封装密钥的字节数 c（= n 的字节数）
+    //   12  c 字节大端整数 r^e mod n，r 在 [2, n-1] 内均匀随机
+    //   之后若干帧：u32 本帧明文字节数（最高位为末帧标志），随后等长密文和 16 字节 Poly1305 标签
+    // 会话密钥 K = SHA-256(r 的 c 字节大端表示 || 00 00 00 01)（KDF2）。第 i 帧用 ChaCha20-Poly1305 加密，
+    // nonce 为 u32 末帧标志 || u64 帧序号，附加数据为头部前 12 字节；末帧标志进入 nonce，截断或调换帧都会认证失败
+    static constexpr char HYBRID_MAGIC[4] = {'R', 'S', 'A', 'H'};
+    static constexpr unsigned char HYBRID_VERSION = 1;
+    static constexpr size_t HYBRID_PREFIX_SIZE = 12;
+    static constexpr uint32_t HYBRID_FINAL_FLAG = 0x80000000u;
+    // 会话密钥的熵不超过 r 的位数：模数不足 512 位（级别 0-4）时拒绝混合加密
+    static constexpr size_t HYBRID_MIN_BYTES = 64;
+
+    static void deriveSessionKey(const BigInt& r, size_t c, unsigned char key[ChaCha20Poly1305::KEY_SIZE]) {
+        std::vector<unsigned char> input(c + 4, 0);
+        r.toBytes(input.data(), c);
+        input[c + 3] = 1;
+        SHA256::Digest digest = SHA256::hash(input.data(), input.size());
+        std::memcpy(key, digest.data(), ChaCha20Poly1305::KEY_SIZE);
+    }
+
+    static void frameNonce(uint64_t index, bool last, unsigned char nonce[ChaCha20Poly1305::NONCE_SIZE]) {
+        putLE32(nonce, last ? 1 : 0);
+        for (int i = 0; i < 8; ++i) nonce[4 + i] = (unsigned char)(index >> (8 * i));
+    }
+
+    // 一批最多 pool->size() + 1 帧，帧之间互不依赖，在线程池中并行加解密
+    uint64_t encryptHybridStream(const RSAKey& snapshot, std::istream& in, std::ostream& out, ThreadPool* pool) const {
+        if (!snapshot.hasPublicKey()) {
+            throw std::runtime_error("公钥未设置！");
         }
+        size_t c = snapshot.cipherBytes();
+        if (c < HYBRID_MIN_BYTES) throw std::runtime_error("模数太小，无法使用混合加密！");
 
-        std::vector<BigInt> encrypted;
-        
-        // 
-        std::string num;
-        for (char c : ciphertext) {
-            if (c == ' ') {
-                if (!num.empty()) {
-                    encrypted.push_back(BigInt(num));
-                    num.clear();
+        // 封装随机会话密钥：只有这一次模幂与密钥长度有关
+        SystemRandom rng;
+        BigInt r = BigInt::randomRange(BigInt(2), snapshot.n - BigInt(1), rng);
+        std::vector<unsigned char> header(HYBRID_PREFIX_SIZE + c, 0);
+        std::memcpy(header.data(), HYBRID_MAGIC, 4);
+        header[4] = HYBRID_VERSION;
+        putLE32(&header[8], (uint32_t)c);
+        snapshot.publicPow(r).toBytes(&header[HYBRID_PREFIX_SIZE], c);
+        unsigned char sessionKey[ChaCha20Poly1305::KEY_SIZE];
+        deriveSessionKey(r, c, sessionKey);
+        out.write(reinterpret_cast<const char*>(header.data()), (std::streamsize)header.size());
+
+        const size_t frameBytes = STREAM_FRAME_BYTES;
+        const size_t sealedBytes = 4 + frameBytes + ChaCha20Poly1305::TAG_SIZE;
+        size_t batch = pool ? pool->size() + 1 : 1;
+        std::unique_ptr<unsigned char[]> sealed(new unsigned char[batch * sealedBytes]);
+        std::vector<size_t> lengths(batch);
+        uint64_t index = 0;
+        uint64_t total = 0;
+        bool last = false;
+        while (!last) {
+            // 明文直接读到密文位置，原地加密
+            size_t frames = 0;
+            while (frames < batch && !last) {
+                unsigned char* frame = sealed.get() + frames * sealedBytes;
+                in.read(reinterpret_cast<char*>(frame + 4), (std::streamsize)frameBytes);
+                lengths[frames] = (size_t)in.gcount();
+                last = lengths[frames] < frameBytes || in.peek() == std::char_traits<char>::eof();
+                ++frames;
+            }
+
+            runBlocks(pool, frames, 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    unsigned char* frame = sealed.get() + i * sealedBytes;
+                    bool isLast = last && i + 1 == frames;
+                    unsigned char nonce[ChaCha20Poly1305::NONCE_SIZE];
+                    frameNonce(index + i, isLast, nonce);
+                    putLE32(frame, (uint32_t)lengths[i] | (isLast ? HYBRID_FINAL_FLAG : 0));
+                    ChaCha20Poly1305::seal(sessionKey, nonce, header.data(), HYBRID_PREFIX_SIZE,
+                                           frame + 4, lengths[i], frame + 4, frame + 4 + lengths[i]);
                 }
-            } else {
-                num += c;
+            });
+
+            for (size_t i = 0; i < frames; ++i) {
+                out.write(reinterpret_cast<const char*>(sealed.get() + i * sealedBytes),
+                          (std::streamsize)(4 + lengths[i] + ChaCha20Poly1305::TAG_SIZE));
+                total += lengths[i];
             }
+            index += frames;
         }
-        if (!num.empty()) {
-            encrypted.push_back(BigInt(num));
+        if (!out) throw std::runtime_error("写入密文失败！");
+        return total;
+    }
+
+    // 魔数已由 decryptStream 读出
+    uint64_t decryptHybridStream(const RSAKey& snapshot, std::istream& in, std::ostream& out, ThreadPool* pool) const {
+        size_t c = snapshot.cipherBytes();
+        if (c < HYBRID_MIN_BYTES) throw std::runtime_error("模数太小，无法使用混合加密！");
+        std::vector<unsigned char> header(HYBRID_PREFIX_SIZE + c);
+        std::memcpy(header.data(), HYBRID_MAGIC, 4);
+        if (!in.read(reinterpret_cast<char*>(&header[4]), HYBRID_PREFIX_SIZE - 4) || header[4] != HYBRID_VERSION) {
+            throw std::runtime_error("不是有效的混合加密密文！");
         }
-        
-        // 
-        std::string result;
-        for (const BigInt& cipher : encrypted) {
-            BigInt m = BigInt::modPow(cipher, d, n);
-            result += char(std::stoll(m.toString()));
+        if (getLE32(&header[8]) != c) {
+            throw std::runtime_error("密文与当前密钥的长度不符！");
         }
-        
-        return result;
+        if (!in.read(reinterpret_cast<char*>(&header[HYBRID_PREFIX_SIZE]), (std::streamsize)c)) {
+            throw std::runtime_error("密文不完整！");
+        }
+        BigInt encapsulated = BigInt::fromBytes(&header[HYBRID_PREFIX_SIZE], c);
+        if (encapsulated >= snapshot.n) throw std::runtime_error("密文块超出模数范围！");
+        unsigned char sessionKey[ChaCha20Poly1305::KEY_SIZE];
+        deriveSessionKey(snapshot.privatePow(encapsulated), c, sessionKey);
+
+        size_t batch = pool ? pool->size() + 1 : 1;
+        std::vector<std::vector<unsigned char>> sealed(batch);
+        std::vector<size_t> lengths(batch);
+        uint64_t index = 0;
+        uint64_t total = 0;
+        bool last = false;
+        while (!last) {
+            size_t frames = 0;
+            while (frames < batch && !last) {
+                unsigned char word[4];
+                if (!in.read(reinterpret_cast<char*>(word), 4)) {
+                    throw std::runtime_error("密文不完整！");
+                }
+                uint32_t len = getLE32(word);
+                last = (len & HYBRID_FINAL_FLAG) != 0;
+                len &= ~HYBRID_FINAL_FLAG;
+                if (len > STREAM_MAX_FRAME) throw std::runtime_error("密文帧长度超出范围！");
+                sealed[frames].resize(len + ChaCha20Poly1305::TAG_SIZE);
+                if (!in.read(reinterpret_cast<char*>(sealed[frames].data()), (std::streamsize)sealed[frames].size())) {
+                    throw std::runtime_error("密文不完整！");
+                }
+                lengths[frames] = len;
+                ++frames;
+            }
+
+            runBlocks(pool, frames, 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    unsigned char nonce[ChaCha20Poly1305::NONCE_SIZE];
+                    frameNonce(index + i, last && i + 1 == frames, nonce);
+                    unsigned char* data = sealed[i].data();
+                    if (!ChaCha20Poly1305::open(sessionKey, nonce, header.data(), HYBRID_PREFIX_SIZE,
+                                                data, lengths[i], data + lengths[i], data)) {
+                        throw std::runtime_error("密文认证失败！");
+                    }
+                }
+            });
+
+            // 整批认证通过后才写出明文
+            for (size_t i = 0; i < frames; ++i) {
+                out.write(reinterpret_cast<const char*>(sealed[i].data()), (std::streamsize)lengths[i]);
+                total += lengths[i];
+            }
+            index += frames;
+        }
+        if (!out) throw std::runtime_error("写入明文失败！");
+        return total;
     }
 
-    // ȡԿ
-    std::pair<BigInt, BigInt> getPublicKey() const {
-        return {e, n};
+    static std::string signWith(const RSAKey& snapshot, const SHA256::Digest& digest) {
+        if (!snapshot.hasPrivateKey()) {
+            throw std::runtime_error("私钥未设置！");
+        }
+        return snapshot.signDigest(digest);
     }
 
-    // ȡ˽Կ
-    std::pair<BigInt, BigInt> getPrivateKey() const {
-        return {d, n};
+    static bool verifyWith(const RSAKey& snapshot, const SHA256::Digest& digest, const std::string& signature) {
+        if (!snapshot.hasPublicKey()) {
+            throw std::runtime_error("公钥未设置！");
+        }
+        return snapshot.verifyDigest(digest, reinterpret_cast<const unsigned char*>(signature.data()), signature.size());
     }
 
-    // ʾԿϢ
-    void displayKeys() const {
-        std::cout << "=== RSA ԿϢ ===" << std::endl;
-        std::cout << "Կ (e, n):" << std::endl;
-        std::cout << "  e = " << e << std::endl;
-        std::cout << "  n = " << n << std::endl;
-        std::cout << "˽Կ (d, n):" << std::endl;
-        std::cout << "  d = " << d << std::endl;
-        std::cout << "  n = " << n << std::endl;
-        std::cout << "=====================" << std::endl;
+    static SHA256::Digest hashStream(std::istream& in) {
+        SHA256 sha;
+        std::unique_ptr<char[]> buf(new char[STREAM_FRAME_BYTES]);
+        while (in) {
+            in.read(buf.get(), (std::streamsize)STREAM_FRAME_BYTES);
+            sha.update(buf.get(), (size_t)in.gcount());
+        }
+        return sha.final();
     }
 
-    // ԿǷ
-    bool hasPublicKey() const {
-        return !e.isZero() && !n.isZero();
+    static size_t verifyManyImpl(std::vector<SignatureCheck>& checks, ThreadPool* pool) {
+        std::vector<size_t> order(checks.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(), [&checks](size_t a, size_t b) {
+            return std::less<const RSAKey*>()(checks[a].key.get(), checks[b].key.get());
+        });
+
+        runBlocks(pool, order.size(), 0, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                SignatureCheck& check = checks[order[i]];
+                check.valid = check.key && check.key->verifyDigest(
+                    SHA256::hash(check.message.data(), check.message.size()),
+                    reinterpret_cast<const unsigned char*>(check.signature.data()), check.signature.size());
+            }
+        });
+        return (size_t)std::count_if(checks.begin(), checks.end(), [](const SignatureCheck& c) { return c.valid; });
     }
 
-    bool hasPrivateKey() const {
-        return !d.isZero() && !n.isZero();
+    // pool 为空时在当前线程顺序执行
+    template <typename F>
+    static void runBlocks(ThreadPool* pool, size_t count, size_t chunkSize, F fn) {
+        if (pool) pool->parallelFor(count, chunkSize, fn);
+        else fn(0, count);
     }
 
-private:
-    BigInt e; // Կָ
-    BigInt d; // ˽Կָ
-    BigInt n; // ģ
+    std::string encryptImpl(const RSAKey& snapshot, const std::string& plaintext, Mode mode,
+                            ThreadPool* pool, size_t chunkSize) const {
+        if (!snapshot.hasPublicKey()) {
+            throw std::runtime_error("公钥未设置！");
+        }
+
+        if (mode == Mode::Binary || mode == Mode::Hybrid) {
+            std::istringstream in(plaintext);
+            std::ostringstream out;
+            if (mode == Mode::Hybrid) encryptHybridStream(snapshot, in, out, pool);
+            else encryptStream(snapshot, in, out, pool, chunkSize);
+            return out.str();
+        }
+
+        // 切分明文：每个字节一块，或每 k 字节打包成一块（末块补零）
+        std::string header;
+        size_t k = 1;
+        if (mode == Mode::Block) {
+            k = snapshot.blockBytes();
+            if (k == 0) throw std::runtime_error("模数太小，无法使用分组模式！");
+            header = "B" + std::to_string(plaintext.size());
+        }
+        size_t blocks = (plaintext.size() + k - 1) / k;
+
+        // 逐字节模式只有 256 种明文，直接查表
+        if (mode == Mode::PerByte) {
+            std::shared_ptr<const RSAKey::ByteTable> table = snapshot.getByteTable();
+            size_t total = 0;
+            for (unsigned char c : plaintext) total += table->cipher[c].size() + 1;
+            std::string result;
+            result.reserve(total);
+            for (unsigned char c : plaintext) {
+                if (!result.empty()) result += ' ';
+                result += table->cipher[c];
+            }
+            return result;
+        }
+
+        std::vector<BigInt> encrypted(blocks);
+        runBlocks(pool, blocks, chunkSize, [&](size_t begin, size_t end) {
+            std::vector<unsigned char> buf(k);
+            for (size_t i = begin; i < end; ++i) {
+                size_t len = std::min(k, plaintext.size() - i * k);
+                std::fill(buf.begin(), buf.end(), 0);
+                std::copy(plaintext.begin() + i * k, plaintext.begin() + i * k + len, buf.begin());
+                LimbArena::Scope scope;
+                BigInt m = BigInt::fromBytes(buf.data(), k);
+                BigInt c = snapshot.publicPow(m);
+                LimbArena::Suspend suspend; // 结果要留到块结束之后，复制到堆上
+                encrypted[i] = c;
+            }
+        });
+
+        // 将加密结果转换为字符串：按长度上限一次性分配，各块直接写入
+        size_t total = header.size();
+        for (const BigInt& c : encrypted) total += c.decimalLengthBound() + 1;
+        std::string result(total, '\0');
+        char* out = std::copy(header.begin(), header.end(), &result[0]);
+        for (size_t i = 0; i < encrypted.size(); ++i) {
+            if (i > 0 || !header.empty()) *out++ = ' ';
+            LimbArena::Scope scope;
+            out = encrypted[i].toChars(out);
+        }
+        result.resize(out - result.data());
+
+        return result;
+    }
+
+    std::string decryptImpl(const RSAKey& snapshot, const std::string& ciphertext, ThreadPool* pool, size_t chunkSize) const {
+        if (!snapshot.hasPrivateKey()) {
+            throw std::runtime_error("私钥未设置！");
+        }
+
+        if (ciphertext.compare(0, 4, STREAM_MAGIC, 4) == 0 || ciphertext.compare(0, 4, HYBRID_MAGIC, 4) == 0) {
+            std::istringstream in(ciphertext);
+            std::ostringstream out;
+            decryptStream(snapshot, in, out, pool, chunkSize);
+            return out.str();
+        }
+
+        // 解析密文：只记录每个数字的位置，转换交给各个块
+        std::vector<std::pair<size_t, size_t>> tokens;
+        size_t start = 0;
+        for (size_t i = 0; i <= ciphertext.size(); ++i) {
+            if (i == ciphertext.size() || ciphertext[i] == ' ') {
+                if (i > start) tokens.push_back({start, i - start});
+                start = i + 1;
+            }
+        }
+
+        // 分组模式的密文以 "B<明文字节数>" 开头
+        size_t k = 1;
+        size_t first = 0;
+        size_t plainLen = tokens.size();
+        if (!tokens.empty() && ciphertext[tokens[0].first] == 'B') {
+            k = snapshot.blockBytes();
+            if (k == 0) throw std::runtime_error("模数太小，无法使用分组模式！");
+            plainLen = std::stoull(ciphertext.substr(tokens[0].first + 1, tokens[0].second - 1));
+            first = 1;
+            if (plainLen > (tokens.size() - 1) * k) throw std::runtime_error("密文长度与头部不符！");
+        }
+        size_t blocks = tokens.size() - first;
+
+        // 逐字节密文先查反向表，查不到（如只有私钥）时再做私钥运算
+        std::shared_ptr<const RSAKey::ByteTable> table;
+        if (first == 0 && !snapshot.e.isZero()) table = snapshot.getByteTable();
+
+        // 解密
+        std::string result(blocks * k, '\0');
+        runBlocks(pool, blocks, chunkSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const std::pair<size_t, size_t>& tok = tokens[first + i];
+                if (table) {
+                    auto it = table->plain.find(std::string_view(ciphertext).substr(tok.first, tok.second));
+                    if (it != table->plain.end()) {
+                        result[i] = char(it->second);
+                        continue;
+                    }
+                }
+                LimbArena::Scope scope;
+                const char* digits = ciphertext.data() + tok.first;
+                BigInt cipher = BigInt::fromDecimal(digits, digits + tok.second);
+                BigInt m = snapshot.privatePow(cipher);
+                m.toBytes(reinterpret_cast<unsigned char*>(&result[i * k]), k);
+            }
+        });
+        result.resize(plainLen);
+        
+        return result;
+    }
 };
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <random>
+
+// 以 std::random_device 为熵源的 64 位随机数发生器（满足 UniformRandomBitGenerator）。
+// libstdc++ / libc++ / MSVC 在常见平台上由 RDRAND、getrandom 或 /dev/urandom 等系统熵源提供，
+// 每次取值都直接读取熵源，没有可被还原的内部状态。用于素数候选、会话密钥等需要保密的随机数。
+// 同一个对象不能被多个线程同时使用。
+class SystemRandom {
+public:
+    using result_type = uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~(result_type)0; }
+
+    result_type operator()() {
+        return (uint64_t)device() << 32 | (uint32_t)device();
+    }
+
+private:
+    std::random_device device;
+};
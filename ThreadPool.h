@@ -0,0 +1,128 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <exception>
+
+// 固定大小的工作线程池。线程在构造时创建、析构时回收，
+// 批量任务通过 parallelFor 按块分发，避免每个数据块都创建一次线程。
+class ThreadPool {
+public:
+    // threads 为 0 时使用硬件并发数
+    explicit ThreadPool(size_t threads = 0) : stopping(false) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    // 对 [0, count) 并行调用 fn(begin, end)，每块最多 chunkSize 个元素；
+    // 调用线程也参与执行，返回时所有块均已完成。任一块抛出的第一个异常会被重新抛出。
+    // chunkSize 为 0 时按线程数自动分块（每个线程约 4 块，便于负载均衡）。
+    template <typename F>
+    void parallelFor(size_t count, size_t chunkSize, F fn) {
+        if (count == 0) return;
+        if (chunkSize == 0) {
+            size_t chunks = (workers.size() + 1) * 4;
+            chunkSize = std::max<size_t>(1, (count + chunks - 1) / chunks);
+        }
+        size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+        Batch batch;
+        batch.pending = chunks;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t c = 0; c < chunks; ++c) {
+                size_t begin = c * chunkSize;
+                size_t end = std::min(count, begin + chunkSize);
+                tasks.push_back([&batch, &fn, begin, end] {
+                    try {
+                        fn(begin, end);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> guard(batch.errorMutex);
+                        if (!batch.error) batch.error = std::current_exception();
+                    }
+                    batch.finish();
+                });
+            }
+        }
+        wake.notify_all();
+
+        // 调用线程帮忙执行队列中的任务，队列取空后等待其余线程完成本批次
+        while (true) {
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (tasks.empty()) break;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+        batch.wait();
+
+        if (batch.error) std::rethrow_exception(batch.error);
+    }
+
+private:
+    // 一次 parallelFor 调用的完成计数
+    struct Batch {
+        size_t pending = 0;
+        std::mutex doneMutex;
+        std::condition_variable done;
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        // 计数在锁内递减，保证 wait 返回后不再有线程访问本对象
+        void finish() {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (--pending == 0) done.notify_all();
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            done.wait(lock, [this] { return pending == 0; });
+        }
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
@@ -0,0 +1,323 @@
+// 性能基准测试：覆盖 BigInt 基本运算、素数生成、RSA 加解密、签名和对称密码，
+// 结果以 CSV 或 JSON 输出，便于不同构建之间对比。
+// 测量前先用已知答案向量自检 SHA-256 和 ChaCha20-Poly1305，结果不符时不做测量。
+//
+// 用法：rsa_bench [--format csv|json] [--out 文件] [--min-time 毫秒] [--filter 子串]
+//       rsa_bench --self-test      只做自检，全部通过时返回 0
+#include "BigInt.h"
+#include "RSA.h"
+#include "PrimeGenerator.h"
+#include "ChaCha20Poly1305.h"
+#include "SHA256.h"
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchResult {
+    std::string group;
+    std::string name;
+    size_t size;        // 操作数位数或消息字节数
+    long long iterations;
+    double nsPerOp;
+};
+
+struct BenchOptions {
+    std::string format = "csv";
+    std::string outFile;
+    double minTimeMs = 200.0;
+    std::string filter;
+};
+
+BenchOptions options;
+std::vector<BenchResult> results;
+size_t sink = 0; // 防止编译器把被测代码优化掉
+
+// 反复执行 fn 直到累计时间超过 minTimeMs，记录平均每次耗时
+void measure(const std::string& group, const std::string& name, size_t size, const std::function<void()>& fn) {
+    std::string id = group + "/" + name + "/" + std::to_string(size);
+    if (!options.filter.empty() && id.find(options.filter) == std::string::npos) return;
+
+    using Clock = std::chrono::steady_clock;
+    fn(); // 预热
+
+    long long iterations = 0;
+    long long batch = 1;
+    double elapsedNs = 0;
+    while (elapsedNs < options.minTimeMs * 1e6) {
+        auto start = Clock::now();
+        for (long long i = 0; i < batch; ++i) fn();
+        elapsedNs += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        iterations += batch;
+        if (batch < (1LL << 20)) batch *= 2;
+    }
+
+    results.push_back({group, name, size, iterations, elapsedNs / iterations});
+    std::fprintf(stderr, "%-40s %14.1f ns/op  (%lld iters)\n", id.c_str(), elapsedNs / iterations, iterations);
+}
+
+std::vector<unsigned char> fromHex(const char* hex) {
+    std::vector<unsigned char> bytes;
+    for (; hex[0] && hex[1]; hex += 2) bytes.push_back((unsigned char)std::stoi(std::string(hex, 2), nullptr, 16));
+    return bytes;
+}
+
+bool check(const char* name, bool ok) {
+    std::fprintf(stderr, "%-40s %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// 已知答案测试：FIPS 180-2 附录 B 的 SHA-256 向量和 RFC 8439 2.8.2 的 AEAD 向量；
+// 另外把同一段密钥流按不同长度分段生成，检查 4 路并行的批处理与逐字节路径衔接一致
+bool selfTest() {
+    bool ok = true;
+    const std::pair<const char*, const char*> sha[] = {
+        {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+         "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+    };
+    for (const auto& v : sha) {
+        SHA256::Digest digest = SHA256::hash(v.first);
+        std::string name = "self-test/sha256/\"" + std::string(v.first).substr(0, 8) + "\"";
+        ok &= check(name.c_str(), std::equal(digest.begin(), digest.end(), fromHex(v.second).begin()));
+    }
+
+    std::vector<unsigned char> key = fromHex("808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f");
+    std::vector<unsigned char> nonce = fromHex("070000004041424344454647");
+    std::vector<unsigned char> aad = fromHex("50515253c0c1c2c3c4c5c6c7");
+    std::string plain = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, "
+                        "sunscreen would be it.";
+    std::vector<unsigned char> expected = fromHex(
+        "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d63dbea45e8ca9671282fafb69da92728b"
+        "1a71de0a9e060b2905d6a5b67ecd3b3692ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+        "3ff4def08e4b7a9de576d26586cec64b6116");
+    std::vector<unsigned char> expectedTag = fromHex("1ae10b594f09e26a7e902ecbd0600691");
+    std::vector<unsigned char> cipher(plain.size()), opened(plain.size());
+    unsigned char tag[ChaCha20Poly1305::TAG_SIZE];
+    ChaCha20Poly1305::seal(key.data(), nonce.data(), aad.data(), aad.size(),
+                           reinterpret_cast<const unsigned char*>(plain.data()), plain.size(), cipher.data(), tag);
+    ok &= check("self-test/chacha20poly1305/seal", cipher == expected &&
+                                                   std::equal(tag, tag + sizeof(tag), expectedTag.begin()));
+    bool opens = ChaCha20Poly1305::open(key.data(), nonce.data(), aad.data(), aad.size(), cipher.data(),
+                                        cipher.size(), tag, opened.data());
+    tag[0] ^= 1;
+    bool rejects = !ChaCha20Poly1305::open(key.data(), nonce.data(), aad.data(), aad.size(), cipher.data(),
+                                           cipher.size(), tag, opened.data());
+    ok &= check("self-test/chacha20poly1305/open",
+                opens && rejects && std::equal(opened.begin(), opened.end(), plain.begin()));
+
+    std::vector<unsigned char> whole(2000, 0), pieces(2000, 0);
+    ChaCha20(key.data(), nonce.data(), 1).process(whole.data(), whole.data(), whole.size());
+    ChaCha20 stream(key.data(), nonce.data(), 1);
+    size_t pos = 0;
+    for (size_t step : {1, 63, 64, 65, 255, 256, 257, 3, 1000}) {
+        size_t len = std::min(step, pieces.size() - pos);
+        stream.process(pieces.data() + pos, pieces.data() + pos, len);
+        pos += len;
+    }
+    stream.process(pieces.data() + pos, pieces.data() + pos, pieces.size() - pos);
+    ok &= check("self-test/chacha20/segmented", whole == pieces);
+    return ok;
+}
+
+BigInt randomBits(size_t bits, std::mt19937_64& gen) {
+    std::vector<unsigned char> bytes((bits + 7) / 8);
+    for (unsigned char& b : bytes) b = (unsigned char)gen();
+    if (bits % 8) bytes[0] &= (unsigned char)((1u << (bits % 8)) - 1);
+    bytes[0] |= (unsigned char)(1u << ((bits - 1) % 8)); // 最高位置 1，保证位数准确
+    return BigInt::fromBytes(bytes.data(), bytes.size());
+}
+
+void benchBigInt() {
+    std::mt19937_64 gen(12345);
+    for (size_t bits : {64, 256, 512, 1024, 2048, 4096}) {
+        BigInt a = randomBits(bits, gen);
+        BigInt b = randomBits(bits, gen);
+        BigInt half = randomBits(bits / 2, gen);
+        BigInt mod = randomBits(bits, gen) + BigInt(1);
+        if (!mod.isOdd()) mod = mod + BigInt(1);
+        BigInt exp = randomBits(bits, gen);
+        std::string dec = a.toString();
+        std::string hex = a.toHexString();
+
+        measure("bigint", "add", bits, [&] { sink += (a + b).bitLength(); });
+        measure("bigint", "mul", bits, [&] { sink += (a * b).bitLength(); });
+        measure("bigint", "div", bits, [&] { sink += (a / half).bitLength(); });
+        measure("bigint", "mod", bits, [&] { sink += (a % half).bitLength(); });
+        measure("bigint", "modPow", bits, [&] { sink += BigInt::modPow(a, exp, mod).bitLength(); });
+        measure("bigint", "gcd", bits, [&] { sink += BigInt::gcd(a, b).bitLength(); });
+        measure("bigint", "modInverse", bits, [&] { sink += BigInt::modInverse(a % mod, mod).bitLength(); });
+        measure("bigint", "toString", bits, [&] { sink += a.toString().size(); });
+        measure("bigint", "fromString", bits, [&] { sink += BigInt(dec).bitLength(); });
+        measure("bigint", "toHexString", bits, [&] { sink += a.toHexString().size(); });
+        measure("bigint", "fromHexString", bits, [&] { sink += BigInt::fromHexString(hex).bitLength(); });
+    }
+}
+
+void benchPrimes() {
+    for (int level = 0; level <= 7; ++level) {
+        std::pair<BigInt, BigInt> pq = PrimeGenerator::getSafePrimePair(level);
+        size_t bits = pq.first.bitLength();
+        measure("prime", "isProbablePrime_L" + std::to_string(level), bits,
+                [&] { sink += PrimeGenerator::isProbablePrime(pq.first) ? 1 : 0; });
+        measure("prime", "getSafePrimePair_L" + std::to_string(level), bits,
+                [&] { sink += PrimeGenerator::getSafePrimePair(level).first.bitLength(); });
+        if (PrimeGenerator::modulusBitsForLevel(level) > 0) {
+            measure("prime", "getSafePrimePairParallel_L" + std::to_string(level), bits,
+                    [&] { sink += PrimeGenerator::getSafePrimePairParallel(level).first.bitLength(); });
+        }
+    }
+}
+
+void benchRSA() {
+    std::pair<BigInt, BigInt> pq = PrimeGenerator::getSafePrimePair(4);
+    RSA rsa;
+    rsa.initialize(pq.first, pq.second);
+    // 混合加密要求模数至少 512 位，改用级别 5 的密钥；数据部分的速度与密钥长度无关
+    std::pair<BigInt, BigInt> hybridPq = PrimeGenerator::getSafePrimePair(5);
+    RSA hybridRsa;
+    hybridRsa.initialize(hybridPq.first, hybridPq.second);
+
+    for (size_t len : {16, 256, 4096}) {
+        std::string message(len, '\0');
+        for (size_t i = 0; i < len; ++i) message[i] = char('A' + i % 26);
+
+        std::string perByte = rsa.encrypt(message);
+        std::string block = rsa.encrypt(message, RSA::Mode::Block);
+        std::string binary = rsa.encrypt(message, RSA::Mode::Binary);
+        std::string hybrid = hybridRsa.encrypt(message, RSA::Mode::Hybrid);
+
+        measure("rsa", "encrypt_perbyte", len, [&] { sink += rsa.encrypt(message).size(); });
+        measure("rsa", "decrypt_perbyte", len, [&] { sink += rsa.decrypt(perByte).size(); });
+        measure("rsa", "encrypt_block", len, [&] { sink += rsa.encrypt(message, RSA::Mode::Block).size(); });
+        measure("rsa", "decrypt_block", len, [&] { sink += rsa.decrypt(block).size(); });
+        measure("rsa", "encrypt_binary", len, [&] { sink += rsa.encrypt(message, RSA::Mode::Binary).size(); });
+        measure("rsa", "decrypt_binary", len, [&] { sink += rsa.decrypt(binary).size(); });
+        measure("rsa", "encrypt_hybrid", len, [&] { sink += hybridRsa.encrypt(message, RSA::Mode::Hybrid).size(); });
+        measure("rsa", "decrypt_hybrid", len, [&] { sink += hybridRsa.decrypt(hybrid).size(); });
+    }
+}
+
+// 同一模数长度下，素因子越多，每次 CRT 模幂的操作数越短
+void benchMultiPrime() {
+    for (size_t bits : {2048, 3072, 4096}) {
+        for (size_t count : {2, 3, 4}) {
+            std::shared_ptr<const RSAKey> key = RSAKey::fromPrimes(PrimeGenerator::getPrimesBitsParallel(bits, count));
+            BigInt c = key->publicPow(BigInt(123456789));
+            measure("multiprime", "privatePow_" + std::to_string(count) + "p", bits,
+                    [&] { sink += key->privatePow(c).bitLength(); });
+        }
+    }
+}
+
+void benchSignature() {
+    std::pair<BigInt, BigInt> pq = PrimeGenerator::getPrimePairBitsParallel(2048);
+    RSA rsa;
+    rsa.initialize(pq.first, pq.second);
+    size_t bits = rsa.getPublicKey().second.bitLength();
+
+    const size_t batch = 64;
+    std::vector<std::string> messages(batch), signatures(batch);
+    std::vector<RSA::SignatureCheck> checks(batch);
+    for (size_t i = 0; i < batch; ++i) {
+        messages[i] = "message " + std::to_string(i);
+        signatures[i] = rsa.sign(messages[i]);
+        checks[i] = {rsa.keyContext(), messages[i], signatures[i]};
+    }
+
+    ThreadPool pool;
+    measure("signature", "sign", bits, [&] { sink += rsa.sign(messages[0]).size(); });
+    measure("signature", "verify", bits, [&] { sink += rsa.verify(messages[0], signatures[0]) ? 1 : 0; });
+    measure("signature", "verifyMany_64", bits, [&] { sink += RSA::verifyMany(checks); });
+    measure("signature", "verifyMany_64_pool", bits, [&] { sink += RSA::verifyMany(checks, pool); });
+}
+
+void benchCipher() {
+    unsigned char key[ChaCha20Poly1305::KEY_SIZE] = {1};
+    unsigned char nonce[ChaCha20Poly1305::NONCE_SIZE] = {2};
+    unsigned char tag[ChaCha20Poly1305::TAG_SIZE];
+    for (size_t len : {64, 4096, 65536}) {
+        std::vector<unsigned char> data(len, 'A');
+        measure("cipher", "chacha20poly1305_seal", len, [&] {
+            ChaCha20Poly1305::seal(key, nonce, nullptr, 0, data.data(), len, data.data(), tag);
+            sink += tag[0];
+        });
+        measure("cipher", "sha256", len, [&] { sink += SHA256::hash(data.data(), len)[0]; });
+    }
+}
+
+void writeResults(std::ostream& os) {
+    if (options.format == "json") {
+        os << "{\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchResult& r = results[i];
+            os << "    {\"group\": \"" << r.group << "\", \"name\": \"" << r.name
+               << "\", \"size\": " << r.size << ", \"iterations\": " << r.iterations
+               << ", \"ns_per_op\": " << r.nsPerOp << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        os << "  ]\n}\n";
+    } else {
+        os << "group,name,size,iterations,ns_per_op\n";
+        for (const BenchResult& r : results) {
+            os << r.group << "," << r.name << "," << r.size << "," << r.iterations << "," << r.nsPerOp << "\n";
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bool selfTestOnly = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--self-test") {
+            selfTestOnly = true;
+        } else if (arg == "--format" && i + 1 < argc) {
+            options.format = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            options.outFile = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.minTimeMs = std::stod(argv[++i]);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else {
+            std::cerr << "用法: " << argv[0]
+                      << " [--format csv|json] [--out 文件] [--min-time 毫秒] [--filter 子串] | --self-test" << std::endl;
+            return 2;
+        }
+    }
+
+    if (!selfTest()) {
+        std::cerr << "自检失败：SHA-256 或 ChaCha20-Poly1305 的结果与已知答案不符" << std::endl;
+        return 1;
+    }
+    if (selfTestOnly) return 0;
+
+    benchBigInt();
+    benchPrimes();
+    benchRSA();
+    benchMultiPrime();
+    benchSignature();
+    benchCipher();
+
+    if (options.outFile.empty()) {
+        writeResults(std::cout);
+    } else {
+        std::ofstream out(options.outFile);
+        if (!out.is_open()) {
+            std::cerr << "无法写入 " << options.outFile << std::endl;
+            return 1;
+        }
+        writeResults(out);
+    }
+    std::fprintf(stderr, "checksum %zu\n", sink);
+    return 0;
+}
@@ -0,0 +1,105 @@
+// 密钥文件工具：在文本格式（每行一个十进制数）和二进制格式之间转换，或查看文件内容。
+//
+// 用法：rsa_keytool convert public|private 输入文件 输出文件 [--to text|binary]
+//       rsa_keytool info 文件
+// convert 未指定 --to 时转换为与输入相反的格式。
+#include "KeyManager.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+int usage(const char* prog) {
+    std::cerr << "用法: " << prog << " convert public|private 输入文件 输出文件 [--to text|binary]\n"
+              << "      " << prog << " info 文件" << std::endl;
+    return 2;
+}
+
+bool loadKey(bool isPublic, const std::string& filename, KeyManager::KeyData& key) {
+    if (isPublic) return KeyManager::loadPublicKey(key.e, key.n, filename);
+    return KeyManager::loadPrivateKey(key, filename);
+}
+
+bool saveKey(bool isPublic, const std::string& filename, const KeyManager::KeyData& key, KeyManager::Format format) {
+    if (format == KeyManager::Format::Binary) return KeyManager::saveBinaryKey(key, filename);
+    if (isPublic) return KeyManager::savePublicKey(key.e, key.n, filename);
+    return KeyManager::savePrivateKey(key, filename);
+}
+
+int convert(int argc, char* argv[]) {
+    if (argc != 5 && argc != 7) return usage(argv[0]);
+    std::string kind = argv[2];
+    if (kind != "public" && kind != "private") return usage(argv[0]);
+    bool isPublic = kind == "public";
+    std::string input = argv[3];
+    std::string output = argv[4];
+
+    bool inputBinary = KeyManager::isBinaryKeyFile(input);
+    KeyManager::Format format = inputBinary ? KeyManager::Format::Text : KeyManager::Format::Binary;
+    if (argc == 7) {
+        std::string opt = argv[5], value = argv[6];
+        if (opt != "--to") return usage(argv[0]);
+        if (value == "text") format = KeyManager::Format::Text;
+        else if (value == "binary") format = KeyManager::Format::Binary;
+        else return usage(argv[0]);
+    }
+
+    KeyManager::KeyData key;
+    if (!loadKey(isPublic, input, key)) {
+        std::cerr << "无法读取" << (isPublic ? "公钥" : "私钥") << "文件 " << input << std::endl;
+        return 1;
+    }
+    if (!saveKey(isPublic, output, key, format)) {
+        std::cerr << "无法写入 " << output << std::endl;
+        return 1;
+    }
+    std::cout << input << (inputBinary ? " (二进制)" : " (文本)") << " -> " << output
+              << (format == KeyManager::Format::Binary ? " (二进制)" : " (文本)") << std::endl;
+    return 0;
+}
+
+int info(int argc, char* argv[]) {
+    if (argc != 3) return usage(argv[0]);
+    std::string filename = argv[2];
+
+    if (!KeyManager::isBinaryKeyFile(filename)) {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "无法打开 " << filename << std::endl;
+            return 1;
+        }
+        std::cout << filename << ": 文本格式" << std::endl;
+        std::string line;
+        for (int i = 1; std::getline(file, line) && !line.empty(); ++i) {
+            std::cout << "  第 " << i << " 行: " << BigInt(line).bitLength() << " 位" << std::endl;
+        }
+        return 0;
+    }
+
+    KeyManager::KeyData key;
+    if (!KeyManager::loadBinaryKey(key, filename)) {
+        std::cerr << filename << ": 二进制密钥文件已损坏（版本、长度或校验和不符）" << std::endl;
+        return 1;
+    }
+    std::cout << filename << ": 二进制格式" << std::endl;
+    const char* names[] = {"e", "d", "n", "p", "q", "dP", "dQ", "qInv"};
+    const BigInt* fields[] = {&key.e, &key.d, &key.n, &key.p, &key.q, &key.dP, &key.dQ, &key.qInv};
+    for (int i = 0; i < 8; ++i) {
+        if (!fields[i]->isZero()) std::cout << "  " << names[i] << ": " << fields[i]->bitLength() << " 位" << std::endl;
+    }
+    for (size_t i = 0; i < key.otherPrimes.size(); ++i) {
+        std::cout << "  r" << i + 3 << ": " << key.otherPrimes[i].r.bitLength() << " 位" << std::endl;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) return usage(argv[0]);
+    std::string command = argv[1];
+    if (command == "convert") return convert(argc, argv);
+    if (command == "info") return info(argc, argv);
+    return usage(argv[0]);
+}
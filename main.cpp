@@ -1,10 +1,42 @@
+// 不带参数运行时进入交互式菜单；带子命令时以批处理方式运行，适合脚本和管道：
+//
+//   RSA keygen [--bits 位数 | --level 级别] [--primes 素因子个数] [--pub 文件] [--priv 文件]
+//              [--format text|binary] [--time]
+//   RSA encrypt -k 公钥 [-o 输出] [-j 线程数] [--hybrid] [--time] [输入文件...]
+//   RSA decrypt -k 私钥 [-o 输出] [-j 线程数] [--time] [输入文件...]
+//   RSA sign -k 私钥 [-o 签名文件] [输入文件...]
+//   RSA verify -k 公钥 [-s 签名文件] [-j 线程数] [--time] [输入文件...]
+//   RSA bench [--bits 位数] [--primes 素因子个数] [--size 字节数] [-j 线程数]
+//
+// encrypt/decrypt 使用二进制分帧密文格式；--hybrid 改用混合加密（RSA 封装会话密钥 + ChaCha20-Poly1305），
+// 适合大文件，decrypt 自动识别两种格式。没有输入文件（或为 "-"）时读标准输入、写标准输出或 -o；
+// 多个输入文件并行处理，加密结果写到 "<输入>.rsa"，解密时去掉 ".rsa" 后缀（没有则加 ".dec"）。
+// sign 把 RSASSA-PKCS1-v1_5（SHA-256）签名写到 "<输入>.sig"；verify 默认从同名 ".sig" 文件读签名，
+// 所有文件一起批量验证，每个文件输出一行结果。
+// --primes 大于 2 时生成多素数密钥，私钥运算在更短的素因子上做 CRT，3072 位以上解密和签名明显更快。
+// 退出码：0 成功，1 运行失败（任一文件出错或签名无效即为 1），2 参数错误。
+// --time 在标准错误输出每个文件的耗时，每行为制表符分隔的：名称 字节数 毫秒 MB/s。
 #include "BigInt.h"
 #include "RSA.h"
 #include "PrimeGenerator.h"
 #include "KeyManager.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <sstream>
 #include <string>
 #include <limits>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 void clearInputBuffer() {
     std::cin.clear();
@@ -12,105 +44,105 @@ void clearInputBuffer() {
 }
 
 void generateNewKeys(RSA& rsa) {
-    std::cout << "\n=== µRSAԿ ===" << std::endl << std::endl;
+    std::cout << "\n=== 生成新的RSA密钥对 ===" << std::endl << std::endl;
     
     PrimeGenerator::displaySecurityLevels();
-    std::cout << "\nѡȫ (0-4): ";
+    std::cout << "\n请选择安全级别 (0-9): ";
     
     int level;
     std::cin >> level;
     clearInputBuffer();
     
-    if (level < 0 || level > 4) {
+    if (level < 0 || level > 9) {
         level = 1;
-        std::cout << "ЧѡʹĬϼ 1" << std::endl;
+        std::cout << "无效选择，使用默认级别 1" << std::endl;
     }
     
-    std::cout << "\nԿ..." << std::endl;
+    std::cout << "\n正在生成密钥对..." << std::endl;
     
-    auto primePair = PrimeGenerator::getSafePrimePair(level);
+    auto primePair = PrimeGenerator::getSafePrimePairParallel(level);
     rsa.initialize(primePair.first, primePair.second);
     
-    std::cout << "? Կɳɹ" << std::endl;
-    std::cout << "\nԿϢ" << std::endl;
-    std::cout << " p = " << primePair.first << std::endl;
-    std::cout << " q = " << primePair.second << std::endl;
-    std::cout << "ģ n = " << rsa.getPublicKey().second << std::endl;
+    std::cout << "? 密钥对生成成功！" << std::endl;
+    std::cout << "\n密钥信息：" << std::endl;
+    std::cout << "素数 p = " << primePair.first << std::endl;
+    std::cout << "素数 q = " << primePair.second << std::endl;
+    std::cout << "模数 n = " << rsa.getPublicKey().second << std::endl;
     
-    // Կ
+    // 保存密钥
     if (rsa.saveKeys()) {
-        std::cout << "\n? Կѱ浽ļ" << std::endl;
-        std::cout << "  - public_key.txt (Կ)" << std::endl;
-        std::cout << "  - private_key.txt (˽Կ)" << std::endl;
+        std::cout << "\n? 密钥已保存到文件：" << std::endl;
+        std::cout << "  - public_key.txt (公钥)" << std::endl;
+        std::cout << "  - private_key.txt (私钥)" << std::endl;
     } else {
-        std::cout << "\n? Կʧܣ" << std::endl;
+        std::cout << "\n? 密钥保存失败！" << std::endl;
     }
 }
 
 void encryptText(const RSA& rsa) {
-    std::cout << "\n=== ı ===" << std::endl;
+    std::cout << "\n=== 加密文本 ===" << std::endl;
     
     if (!rsa.hasPublicKey()) {
-        std::cout << "? δعԿ" << std::endl;
-        std::cout << "ʾѡ˵ѡ 6 ˹Կ" << std::endl;
+        std::cout << "? 错误：未加载公钥！" << std::endl;
+        std::cout << "提示：您可以选择菜单选项 6 导入他人公钥" << std::endl;
         return;
     }
     
-    std::cout << "\nҪܵı" << std::endl;
+    std::cout << "\n请输入要加密的文本：" << std::endl;
     std::string plaintext;
     std::getline(std::cin, plaintext);
     
     if (plaintext.empty()) {
-        std::cout << "? Ϊգ" << std::endl;
+        std::cout << "? 输入为空！" << std::endl;
         return;
     }
     
     try {
-        std::cout << "\nڼ..." << std::endl;
+        std::cout << "\n正在加密..." << std::endl;
         std::string ciphertext = rsa.encrypt(plaintext);
         
-        std::cout << "\n? ܳɹ" << std::endl;
-        std::cout << "\nԭʼı" << plaintext << std::endl;
-        std::cout << "\nģƱܣ" << std::endl;
+        std::cout << "\n? 加密成功！" << std::endl;
+        std::cout << "\n原始文本：" << plaintext << std::endl;
+        std::cout << "\n密文（请妥善保管）：" << std::endl;
         std::cout << ciphertext << std::endl;
     } catch (const std::exception& e) {
-        std::cout << "? ʧܣ" << e.what() << std::endl;
+        std::cout << "? 加密失败：" << e.what() << std::endl;
     }
 }
 
 void decryptText(const RSA& rsa) {
-    std::cout << "\n=== ı ===" << std::endl;
+    std::cout << "\n=== 解密文本 ===" << std::endl;
     
     if (!rsa.hasPrivateKey()) {
-        std::cout << "? δ˽Կ" << std::endl;
+        std::cout << "? 错误：未加载私钥！" << std::endl;
         return;
     }
     
-    std::cout << "\nҪܵģУոָ" << std::endl;
+    std::cout << "\n请输入要解密的密文（数字序列，空格分隔）：" << std::endl;
     std::string ciphertext;
     std::getline(std::cin, ciphertext);
     
     if (ciphertext.empty()) {
-        std::cout << "? Ϊգ" << std::endl;
+        std::cout << "? 输入为空！" << std::endl;
         return;
     }
     
     try {
-        std::cout << "\nڽ..." << std::endl;
+        std::cout << "\n正在解密..." << std::endl;
         std::string plaintext = rsa.decrypt(ciphertext);
         
-        std::cout << "\n? ܳɹ" << std::endl;
-        std::cout << "\nܺı" << plaintext << std::endl;
+        std::cout << "\n? 解密成功！" << std::endl;
+        std::cout << "\n解密后的文本：" << plaintext << std::endl;
     } catch (const std::exception& e) {
-        std::cout << "? ʧܣ" << e.what() << std::endl;
+        std::cout << "? 解密失败：" << e.what() << std::endl;
     }
 }
 
 void importPublicKey(RSA& rsa) {
-    std::cout << "\n=== ˹Կ ===" << std::endl;
-    std::cout << "\nע⣺˹ԿֻϢ" << std::endl;
-    std::cout << "      ҪԷ˽ԿܽܣͨӦӵжԷ˽Կ" << std::endl;
-    std::cout << "\n빫ԿļĬΪ public_key.txt: ";
+    std::cout << "\n=== 导入他人公钥 ===" << std::endl;
+    std::cout << "\n注意：导入他人公钥后，您只能用它来加密消息。" << std::endl;
+    std::cout << "      您需要对方的私钥才能解密（通常您不应拥有对方私钥）。" << std::endl;
+    std::cout << "\n请输入公钥文件名（默认为 public_key.txt）: ";
     
     std::string filename;
     std::getline(std::cin, filename);
@@ -120,46 +152,46 @@ void importPublicKey(RSA& rsa) {
     }
     
     if (rsa.loadPublicKey(filename)) {
-        std::cout << "\n? Կɹ" << std::endl;
+        std::cout << "\n? 公钥导入成功！" << std::endl;
         auto publicKey = rsa.getPublicKey();
-        std::cout << "\nĹԿϢ" << std::endl;
-        std::cout << "Կָ e = " << publicKey.first << std::endl;
-        std::cout << "ģ n = " << publicKey.second << std::endl;
-        std::cout << "\nʹô˹ԿϢˡ" << std::endl;
+        std::cout << "\n导入的公钥信息：" << std::endl;
+        std::cout << "公钥指数 e = " << publicKey.first << std::endl;
+        std::cout << "模数 n = " << publicKey.second << std::endl;
+        std::cout << "\n现在您可以使用此公钥加密消息了。" << std::endl;
     } else {
-        std::cout << "\n? ԿʧܣļǷҸʽȷ" << std::endl;
-        std::cout << "ļʽӦΪ" << std::endl;
-        std::cout << "  һУԿָ e" << std::endl;
-        std::cout << "  ڶУģ n" << std::endl;
+        std::cout << "\n? 公钥导入失败！请检查文件是否存在且格式正确。" << std::endl;
+        std::cout << "文件格式应为：" << std::endl;
+        std::cout << "  第一行：公钥指数 e" << std::endl;
+        std::cout << "  第二行：模数 n" << std::endl;
     }
 }
 
 void displayMenu() {
     std::cout << "\n==============================" << std::endl;
-    std::cout << "    RSA ּӽϵͳ" << std::endl;
+    std::cout << "    RSA 文字加解密系统" << std::endl;
     std::cout << "==============================" << std::endl;
-    std::cout << "1. µRSAԿ" << std::endl;
-    std::cout << "2. ı" << std::endl;
-    std::cout << "3. ı" << std::endl;
-    std::cout << "4. 鿴ԿϢ" << std::endl;
-    std::cout << "5. ¼Կ" << std::endl;
-    std::cout << "6. ˹Կڼܣ" << std::endl;
-    std::cout << "0. ˳" << std::endl;
+    std::cout << "1. 生成新的RSA密钥对" << std::endl;
+    std::cout << "2. 加密文本" << std::endl;
+    std::cout << "3. 解密文本" << std::endl;
+    std::cout << "4. 查看密钥信息" << std::endl;
+    std::cout << "5. 重新加载密钥" << std::endl;
+    std::cout << "6. 导入他人公钥（仅用于加密）" << std::endl;
+    std::cout << "0. 退出程序" << std::endl;
     std::cout << "==============================" << std::endl;
-    std::cout << "ѡ (0-6): ";
+    std::cout << "请选择操作 (0-6): ";
 }
 
-int main() {
+int runInteractive() {
     RSA rsa;
     bool keysLoaded = false;
     
-    std::cout << "\nӭʹ RSA ּӽϵͳ" << std::endl;
+    std::cout << "\n欢迎使用 RSA 文字加解密系统！" << std::endl;
     std::cout << "================================\n" << std::endl;
     
-    // ǷԿļ
+    // 检查是否已有密钥文件
     if (KeyManager::keysExist()) {
-        std::cout << "⵽ѱԿļ" << std::endl;
-        std::cout << "ǷԿ(y/n): ";
+        std::cout << "检测到已保存的密钥文件。" << std::endl;
+        std::cout << "是否加载已有密钥？(y/n): ";
         
         char choice;
         std::cin >> choice;
@@ -167,21 +199,21 @@ int main() {
         
         if (choice == 'y' || choice == 'Y') {
             if (rsa.loadKeys()) {
-                std::cout << "? Կسɹ" << std::endl;
+                std::cout << "? 密钥加载成功！" << std::endl;
                 keysLoaded = true;
                 
                 auto publicKey = rsa.getPublicKey();
-                std::cout << "\nǰԿϢ" << std::endl;
-                std::cout << "ģ n = " << publicKey.second << std::endl;
+                std::cout << "\n当前密钥信息：" << std::endl;
+                std::cout << "模数 n = " << publicKey.second << std::endl;
             } else {
-                std::cout << "? Կʧܣ" << std::endl;
+                std::cout << "? 密钥加载失败！" << std::endl;
             }
         }
     }
     
     if (!keysLoaded) {
-        std::cout << "\n״ʹҪRSAԿԡ" << std::endl;
-        std::cout << "Ƿɣ(y/n): ";
+        std::cout << "\n首次使用需要生成RSA密钥对。" << std::endl;
+        std::cout << "是否现在生成？(y/n): ";
         
         char choice;
         std::cin >> choice;
@@ -193,7 +225,7 @@ int main() {
         }
     }
     
-    // ѭ
+    // 主循环
     while (true) {
         displayMenu();
         
@@ -211,7 +243,7 @@ int main() {
                 if (keysLoaded || rsa.hasPublicKey()) {
                     encryptText(rsa);
                 } else {
-                    std::cout << "\n? ԿԿ빫Կ" << std::endl;
+                    std::cout << "\n? 请先生成密钥、加载密钥或导入公钥！" << std::endl;
                 }
                 break;
                 
@@ -219,7 +251,7 @@ int main() {
                 if (keysLoaded || rsa.hasPrivateKey()) {
                     decryptText(rsa);
                 } else {
-                    std::cout << "\n? ɻԿ" << std::endl;
+                    std::cout << "\n? 请先生成或加载密钥！" << std::endl;
                 }
                 break;
                 
@@ -228,20 +260,20 @@ int main() {
                     std::cout << std::endl;
                     rsa.displayKeys();
                 } else {
-                    std::cout << "\n? δԿ" << std::endl;
+                    std::cout << "\n? 未加载密钥！" << std::endl;
                 }
                 break;
                 
             case 5:
                 if (rsa.loadKeys()) {
-                    std::cout << "\n? Կ¼سɹ" << std::endl;
+                    std::cout << "\n? 密钥重新加载成功！" << std::endl;
                     keysLoaded = true;
                 } else {
-                    std::cout << "\n? Կʧܣ" << std::endl;
-                    std::cout << "ԭ" << std::endl;
-                    std::cout << "  1. Կļ" << std::endl;
-                    std::cout << "  2. Կ˽Կģ n ƥ䣨ԲͬԿԣ" << std::endl;
-                    std::cout << "\nʾֻ뵼빫Կڼܣѡ˵ѡ 6" << std::endl;
+                    std::cout << "\n? 密钥加载失败！" << std::endl;
+                    std::cout << "可能原因：" << std::endl;
+                    std::cout << "  1. 密钥文件不存在" << std::endl;
+                    std::cout << "  2. 公钥和私钥的模数 n 不匹配（来自不同密钥对）" << std::endl;
+                    std::cout << "\n提示：如果只想导入公钥用于加密，请选择菜单选项 6" << std::endl;
                 }
                 break;
                 
@@ -250,17 +282,456 @@ int main() {
                 break;
                 
             case 0:
-                std::cout << "\nлʹ RSA ӽϵͳټ" << std::endl;
+                std::cout << "\n感谢使用 RSA 加解密系统！再见！" << std::endl;
                 return 0;
                 
             default:
-                std::cout << "\n? Чѡ룡" << std::endl;
+                std::cout << "\n? 无效的选择，请重新输入！" << std::endl;
                 break;
         }
         
-        std::cout << "\nس...";
+        std::cout << "\n按回车键继续...";
         std::cin.get();
     }
     
     return 0;
 }
+
+// ---------------- 命令行批处理模式 ----------------
+
+struct CliOptions {
+    std::string keyFile;
+    std::string output;
+    std::string sigFile;
+    std::string pubFile = "public_key.txt";
+    std::string privFile = "private_key.txt";
+    KeyManager::Format format = KeyManager::Format::Text;
+    size_t bits = 2048;
+    int level = -1;
+    size_t primes = 2;
+    size_t jobs = 0;
+    size_t size = 1 << 20;
+    bool time = false;
+    bool hybrid = false;
+    std::vector<std::string> inputs;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// 输出一行计时结果：名称 字节数 毫秒 MB/s（keygen 行的第二列为模数位数）
+void printTiming(std::ostream& os, const std::string& name, uint64_t bytes, double ms) {
+    double mbps = ms > 0 ? bytes / (ms * 1000.0) : 0.0;
+    os << name << '\t' << bytes << '\t' << ms << '\t' << mbps << '\n';
+}
+
+int usage(const char* prog) {
+    std::cerr << "用法: " << prog << "                                  交互式菜单\n"
+              << "      " << prog << " keygen [--bits 位数 | --level 级别] [--primes 素因子个数]"
+              << " [--pub 文件] [--priv 文件] [--format text|binary] [--time]\n"
+              << "      " << prog << " encrypt -k 公钥 [-o 输出] [-j 线程数] [--hybrid] [--time] [输入文件...]\n"
+              << "      " << prog << " decrypt -k 私钥 [-o 输出] [-j 线程数] [--time] [输入文件...]\n"
+              << "      " << prog << " sign -k 私钥 [-o 签名文件] [输入文件...]\n"
+              << "      " << prog << " verify -k 公钥 [-s 签名文件] [-j 线程数] [--time] [输入文件...]\n"
+              << "      " << prog << " bench [--bits 位数] [--primes 素因子个数] [--size 字节数] [-j 线程数]" << std::endl;
+    return 2;
+}
+
+// 数值参数的上限：超出时按用法错误处理，而不是尝试创建海量线程或分配巨大的缓冲区
+const size_t MAX_BITS = 16384;
+const size_t MAX_PRIMES = 16;
+const size_t MAX_LEVEL = 9;
+const size_t MAX_SIZE = size_t(1) << 30;
+
+size_t maxJobs() {
+    return 4 * (size_t)std::max(1u, std::thread::hardware_concurrency());
+}
+
+// 解析不大于 maxValue 的十进制非负整数；负号、其它非数字字符或超出上限时返回 false
+bool parseCount(const std::string& text, size_t maxValue, size_t& value) {
+    if (text.empty()) return false;
+    size_t result = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        size_t digit = (size_t)(c - '0');
+        if (digit > maxValue || result > (maxValue - digit) / 10) return false;
+        result = result * 10 + digit;
+    }
+    value = result;
+    return true;
+}
+
+// 解析 argv[2..]，不认识的选项、缺少参数值或数值参数不合法时返回 false
+bool parseOptions(int argc, char* argv[], CliOptions& opts) {
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((arg == "-k" || arg == "--key") && hasValue) {
+            opts.keyFile = argv[++i];
+        } else if ((arg == "-o" || arg == "--out") && hasValue) {
+            opts.output = argv[++i];
+        } else if ((arg == "-s" || arg == "--sig") && hasValue) {
+            opts.sigFile = argv[++i];
+        } else if ((arg == "-j" || arg == "--jobs") && hasValue) {
+            if (!parseCount(argv[++i], maxJobs(), opts.jobs)) return false;
+        } else if (arg == "--bits" && hasValue) {
+            if (!parseCount(argv[++i], MAX_BITS, opts.bits)) return false;
+        } else if (arg == "--level" && hasValue) {
+            size_t level = 0;
+            if (!parseCount(argv[++i], MAX_LEVEL, level)) return false;
+            opts.level = (int)level;
+        } else if (arg == "--primes" && hasValue) {
+            if (!parseCount(argv[++i], MAX_PRIMES, opts.primes)) return false;
+        } else if (arg == "--size" && hasValue) {
+            if (!parseCount(argv[++i], MAX_SIZE, opts.size)) return false;
+        } else if (arg == "--pub" && hasValue) {
+            opts.pubFile = argv[++i];
+        } else if (arg == "--priv" && hasValue) {
+            opts.privFile = argv[++i];
+        } else if (arg == "--format" && hasValue) {
+            std::string value = argv[++i];
+            if (value == "text") opts.format = KeyManager::Format::Text;
+            else if (value == "binary") opts.format = KeyManager::Format::Binary;
+            else return false;
+        } else if (arg == "--time") {
+            opts.time = true;
+        } else if (arg == "--hybrid") {
+            opts.hybrid = true;
+        } else if (arg == "-" || arg[0] != '-') {
+            opts.inputs.push_back(arg);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 生成素因子：指定 --level 时按安全级别，否则按模数位数；--primes 大于 2 时生成多素数密钥
+std::vector<BigInt> generatePrimes(const CliOptions& opts) {
+    if (opts.primes > 2) {
+        size_t bits = opts.level >= 0 ? PrimeGenerator::modulusBitsForLevel(opts.level) : opts.bits;
+        return PrimeGenerator::getPrimesBitsParallel(bits, opts.primes, opts.jobs);
+    }
+    auto primePair = opts.level >= 0 ? PrimeGenerator::getSafePrimePairParallel(opts.level, opts.jobs)
+                                     : PrimeGenerator::getPrimePairBitsParallel(opts.bits, opts.jobs);
+    return {primePair.first, primePair.second};
+}
+
+int cmdKeygen(const CliOptions& opts) {
+    if (!opts.inputs.empty() || (opts.level < 0 && opts.bits < 16) || opts.level > 9) return 2;
+    // 级别 0-4 按数值范围生成素数对，不支持多素数
+    if (opts.primes < 2 || (opts.primes > 2 && opts.level >= 0 && PrimeGenerator::modulusBitsForLevel(opts.level) == 0)) {
+        return 2;
+    }
+
+    Clock::time_point start = Clock::now();
+    RSA rsa;
+    rsa.initialize(generatePrimes(opts));
+    double ms = elapsedMs(start);
+
+    if (!rsa.saveKeys(opts.pubFile, opts.privFile, opts.format)) {
+        std::cerr << "无法写入密钥文件 " << opts.pubFile << " / " << opts.privFile << std::endl;
+        return 1;
+    }
+    std::cout << opts.pubFile << '\n' << opts.privFile << std::endl;
+    if (opts.time) printTiming(std::cerr, "keygen", rsa.getPublicKey().second.bitLength(), ms);
+    return 0;
+}
+
+// 批量加解密的单个任务：in 为 "-" 表示标准输入，out 为 "-" 表示标准输出
+struct FileJob {
+    std::string in;
+    std::string out;
+};
+
+std::string defaultOutputName(const std::string& input, bool encrypting) {
+    if (encrypting) return input + ".rsa";
+    const std::string suffix = ".rsa";
+    if (input.size() > suffix.size() && input.compare(input.size() - suffix.size(), suffix.size(), suffix) == 0) {
+        return input.substr(0, input.size() - suffix.size());
+    }
+    return input + ".dec";
+}
+
+// 处理一个文件，pool 不为空时帧内的块分发到线程池。出错时删除不完整的输出文件并返回 false
+bool runFileJob(const RSA& rsa, bool encrypting, const FileJob& job, ThreadPool* pool, const CliOptions& opts,
+                std::atomic<uint64_t>& totalBytes) {
+    Clock::time_point start = Clock::now();
+    std::ifstream inFile;
+    std::ofstream outFile;
+    std::istream* in = &std::cin;
+    std::ostream* out = &std::cout;
+    if (job.in != "-") {
+        inFile.open(job.in, std::ios::binary);
+        if (!inFile.is_open()) {
+            std::cerr << job.in << ": 无法打开" << std::endl;
+            return false;
+        }
+        in = &inFile;
+    }
+    if (job.out != "-") {
+        outFile.open(job.out, std::ios::binary | std::ios::trunc);
+        if (!outFile.is_open()) {
+            std::cerr << job.out << ": 无法写入" << std::endl;
+            return false;
+        }
+        out = &outFile;
+    }
+
+    uint64_t bytes = 0;
+    try {
+        if (encrypting && opts.hybrid) bytes = pool ? rsa.encryptHybrid(*in, *out, *pool) : rsa.encryptHybrid(*in, *out);
+        else if (encrypting) bytes = pool ? rsa.encrypt(*in, *out, *pool) : rsa.encrypt(*in, *out);
+        else bytes = pool ? rsa.decrypt(*in, *out, *pool) : rsa.decrypt(*in, *out);
+        out->flush();
+        if (!*out) throw std::runtime_error("写入失败！");
+    } catch (const std::exception& e) {
+        std::cerr << job.in << ": " << (encrypting ? "加密" : "解密") << "失败：" << e.what() << std::endl;
+        if (job.out != "-") {
+            outFile.close();
+            std::remove(job.out.c_str());
+        }
+        return false;
+    }
+
+    totalBytes += bytes;
+    if (opts.time) {
+        std::ostringstream line; // 整行一次写出，避免并行任务的输出交错
+        printTiming(line, job.in, bytes, elapsedMs(start));
+        std::cerr << line.str() << std::flush;
+    }
+    return true;
+}
+
+int cmdCrypt(const CliOptions& opts, bool encrypting) {
+    if (opts.keyFile.empty()) return 2;
+    if (opts.inputs.size() > 1 && !opts.output.empty()) return 2;
+
+    RSA rsa;
+    bool loaded = encrypting ? rsa.loadPublicKey(opts.keyFile) : rsa.loadPrivateKey(opts.keyFile);
+    if (!loaded) {
+        std::cerr << "无法读取" << (encrypting ? "公钥" : "私钥") << "文件 " << opts.keyFile << std::endl;
+        return 1;
+    }
+
+    std::vector<FileJob> jobs;
+    if (opts.inputs.empty()) {
+        jobs.push_back({"-", opts.output.empty() ? "-" : opts.output});
+    } else {
+        for (const std::string& input : opts.inputs) {
+            std::string output = opts.output;
+            if (output.empty()) output = input == "-" ? "-" : defaultOutputName(input, encrypting);
+            jobs.push_back({input, output});
+        }
+    }
+
+    for (const FileJob& job : jobs) {
+#ifdef _WIN32
+        if (job.in == "-") _setmode(_fileno(stdin), _O_BINARY);
+        if (job.out == "-") _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        if ((job.in == "-" || job.out == "-") && jobs.size() > 1) {
+            std::cerr << "多个输入时不能使用标准输入输出" << std::endl;
+            return 2;
+        }
+    }
+
+    Clock::time_point start = Clock::now();
+    ThreadPool pool(opts.jobs);
+    std::atomic<size_t> failed(0);
+    std::atomic<uint64_t> totalBytes(0);
+    if (jobs.size() == 1) {
+        // 单个输入：在文件内部按块并行
+        if (!runFileJob(rsa, encrypting, jobs[0], &pool, opts, totalBytes)) ++failed;
+    } else {
+        // 多个输入：每个文件一个任务，文件之间并行
+        pool.parallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (!runFileJob(rsa, encrypting, jobs[i], nullptr, opts, totalBytes)) ++failed;
+            }
+        });
+    }
+
+    if (opts.time && jobs.size() > 1) printTiming(std::cerr, "total", totalBytes, elapsedMs(start));
+    return failed == 0 ? 0 : 1;
+}
+
+// 读取整个文件，path 为 "-" 时读标准输入
+bool readFile(const std::string& path, std::string& content) {
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (path != "-") {
+        file.open(path, std::ios::binary);
+        if (!file.is_open()) return false;
+        in = &file;
+    }
+    std::ostringstream buf;
+    buf << in->rdbuf();
+    content = buf.str();
+    return !in->bad();
+}
+
+int cmdSign(const CliOptions& opts) {
+    if (opts.keyFile.empty() || !opts.sigFile.empty()) return 2;
+    if (opts.inputs.size() > 1 && !opts.output.empty()) return 2;
+
+    RSA rsa;
+    if (!rsa.loadPrivateKey(opts.keyFile)) {
+        std::cerr << "无法读取私钥文件 " << opts.keyFile << std::endl;
+        return 1;
+    }
+
+    std::vector<FileJob> jobs;
+    if (opts.inputs.empty()) {
+        jobs.push_back({"-", opts.output.empty() ? "-" : opts.output});
+    } else {
+        for (const std::string& input : opts.inputs) {
+            std::string output = opts.output;
+            if (output.empty()) output = input == "-" ? "-" : input + ".sig";
+            jobs.push_back({input, output});
+        }
+    }
+
+    size_t failed = 0;
+    for (const FileJob& job : jobs) {
+        std::ifstream inFile;
+        std::istream* in = &std::cin;
+        if (job.in != "-") {
+            inFile.open(job.in, std::ios::binary);
+            if (!inFile.is_open()) {
+                std::cerr << job.in << ": 无法打开" << std::endl;
+                ++failed;
+                continue;
+            }
+            in = &inFile;
+        }
+        std::string signature = rsa.sign(*in);
+        if (in->bad()) {
+            std::cerr << job.in << ": 读取失败" << std::endl;
+            ++failed;
+            continue;
+        }
+
+#ifdef _WIN32
+        if (job.out == "-") _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        std::ofstream outFile;
+        std::ostream* out = &std::cout;
+        if (job.out != "-") {
+            outFile.open(job.out, std::ios::binary | std::ios::trunc);
+            out = &outFile;
+        }
+        out->write(signature.data(), (std::streamsize)signature.size());
+        out->flush();
+        if (!*out) {
+            std::cerr << job.out << ": 无法写入" << std::endl;
+            ++failed;
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+// 读入全部消息和签名后用 RSA::verifyMany 一次验证，适合大量小文件
+int cmdVerify(const CliOptions& opts) {
+    if (opts.keyFile.empty() || !opts.output.empty()) return 2;
+    std::vector<std::string> inputs = opts.inputs;
+    if (inputs.empty()) inputs.push_back("-");
+    if (inputs.size() > 1 && !opts.sigFile.empty()) return 2;
+    if (inputs.size() == 1 && inputs[0] == "-" && opts.sigFile.empty()) return 2;
+
+    RSA rsa;
+    if (!rsa.loadPublicKey(opts.keyFile)) {
+        std::cerr << "无法读取公钥文件 " << opts.keyFile << std::endl;
+        return 1;
+    }
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::string> messages(inputs.size()), signatures(inputs.size());
+    std::vector<RSA::SignatureCheck> checks;
+    std::vector<size_t> checkInput;
+    size_t failed = 0;
+    uint64_t totalBytes = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        std::string sigFile = opts.sigFile.empty() ? inputs[i] + ".sig" : opts.sigFile;
+        if (!readFile(inputs[i], messages[i]) || !readFile(sigFile, signatures[i])) {
+            std::cerr << inputs[i] << ": 无法读取消息或签名文件 " << sigFile << std::endl;
+            ++failed;
+            continue;
+        }
+        checks.push_back({rsa.keyContext(), messages[i], signatures[i]});
+        checkInput.push_back(i);
+        totalBytes += messages[i].size();
+    }
+
+    ThreadPool pool(opts.jobs);
+    RSA::verifyMany(checks, pool);
+    for (size_t j = 0; j < checks.size(); ++j) {
+        std::cout << inputs[checkInput[j]] << ": " << (checks[j].valid ? "签名有效" : "签名无效") << '\n';
+        if (!checks[j].valid) ++failed;
+    }
+    std::cout << std::flush;
+
+    if (opts.time) printTiming(std::cerr, "total", totalBytes, elapsedMs(start));
+    return failed == 0 ? 0 : 1;
+}
+
+// 内存中生成随机数据，测量密钥生成和流式加解密的吞吐量，输出格式同 --time
+int cmdBench(const CliOptions& opts) {
+    if (!opts.inputs.empty() || opts.bits < 16 || opts.primes < 2) return 2;
+
+    Clock::time_point start = Clock::now();
+    RSA rsa;
+    rsa.initialize(generatePrimes(opts));
+    printTiming(std::cout, "keygen", opts.bits, elapsedMs(start));
+
+    std::string message(opts.size, '\0');
+    std::mt19937_64 gen(12345);
+    for (char& c : message) c = (char)gen();
+
+    ThreadPool pool(opts.jobs);
+    for (bool hybrid : {false, true}) {
+        std::istringstream plainIn(message);
+        std::ostringstream cipherOut;
+        start = Clock::now();
+        if (hybrid) rsa.encryptHybrid(plainIn, cipherOut, pool);
+        else rsa.encrypt(plainIn, cipherOut, pool);
+        printTiming(std::cout, hybrid ? "encrypt_hybrid" : "encrypt", message.size(), elapsedMs(start));
+
+        std::istringstream cipherIn(cipherOut.str());
+        std::ostringstream plainOut;
+        start = Clock::now();
+        rsa.decrypt(cipherIn, plainOut, pool);
+        printTiming(std::cout, hybrid ? "decrypt_hybrid" : "decrypt", message.size(), elapsedMs(start));
+
+        if (plainOut.str() != message) {
+            std::cerr << "解密结果与原文不一致！" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) return runInteractive();
+
+    std::string command = argv[1];
+    CliOptions opts;
+    if (!parseOptions(argc, argv, opts)) return usage(argv[0]);
+
+    int code = 2;
+    try {
+        if (command == "keygen") code = cmdKeygen(opts);
+        else if (command == "encrypt") code = cmdCrypt(opts, true);
+        else if (command == "decrypt") code = cmdCrypt(opts, false);
+        else if (command == "sign") code = cmdSign(opts);
+        else if (command == "verify") code = cmdVerify(opts);
+        else if (command == "bench") code = cmdBench(opts);
+    } catch (const std::exception& e) {
+        std::cerr << "错误：" << e.what() << std::endl;
+        return 1;
+    }
+    return code == 2 ? usage(argv[0]) : code;
+}